@@ -1,46 +1,112 @@
 #pragma once
 
+#include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
 #include <SDL3/SDL.h>
 
+#include <chrono>
 #include <span>
 #include <string_view>
 
 #include "gfx/device.hpp"
+#include "gfx/draw_queue.hpp"
+#include "gfx/lighting.hpp"
+#include "gfx/meshlets.hpp"
+#include "gfx/post_process.hpp"
+#include "gfx/text_overlay.hpp"
+#include "metrics_exporter.hpp"
+#include "scene/bvh.hpp"
+#include "scene/meshlet.hpp"
+#include "thread_pool.hpp"
 #include "types.hpp"
 
 namespace vg {
 
+enum class MeshId : u8 {
+	Quad,
+	Torus, // dense, drawn through the meshlet path
+};
+
+struct Object {
+	glm::mat4 model;
+	glm::vec4 tint;
+	MeshId mesh = MeshId::Quad;
+	u32 proxy = scene::Bvh::INVALID;
+};
+
 struct Vertex {
 	glm::vec3 pos;
+	glm::vec3 normal;
 	glm::vec2 uv;
 };
 
+// Owns sdl and the main window, released on destruction even when only part of startup ran
+struct SdlContext {
+	bool initialized = false;
+	SDL_Window* window = nullptr;
+
+	SdlContext() = default;
+	~SdlContext();
+
+	SdlContext(const SdlContext&) = delete;
+	SdlContext& operator=(const SdlContext&) = delete;
+};
+
 class App {
   public:
 	explicit App(std::span<const std::string_view> args);
-	~App();
 
 	void run();
 	void quit();
 
   private:
+	void downgrade_texture();
+
+	std::chrono::steady_clock::time_point m_start_time;
 	bool m_running = false;
+	bool m_use_mesh_shaders = false;
+	bool m_show_overlay = true;
+	bool m_downgrade_texture = false; // requested by the memory manager under budget pressure
 
-	SDL_Window* m_window = nullptr;
+	// NOTE: a member instead of cleanup in ~App, which never runs when a startup task throws.
+	// declared before the device so the window outlives the swapchain
+	SdlContext m_sdl;
+
+	ThreadPool m_thread_pool;
+	gfx::DrawQueue m_draw_queue {&m_thread_pool};
+
+	scene::Bvh m_bvh {&m_thread_pool};
+	std::vector<Object> m_objects;
+	std::vector<u32> m_visible_objects;
+	scene::RayHit m_picked; // object under the last left click
 
 	std::unique_ptr<gfx::IDevice> m_device;
+	std::unique_ptr<gfx::ClusteredLighting> m_lighting;
+	std::unique_ptr<gfx::PostProcess> m_post_process;
+	std::unique_ptr<gfx::MeshletMesh> m_torus;
+	std::unique_ptr<gfx::TextOverlay> m_overlay;
+	std::unique_ptr<MetricsExporter> m_metrics_exporter;
 
 	nvrhi::GraphicsPipelineHandle m_pipeline;
+	nvrhi::GraphicsPipelineHandle m_translucent_pipeline; // alpha blended, no depth writes
+	nvrhi::GraphicsPipelineHandle m_meshlet_pipeline; // indirect path, back faces culled
+	nvrhi::MeshletPipelineHandle m_mesh_shader_pipeline;
 	nvrhi::CommandListHandle m_command_list;
+	nvrhi::CommandListHandle m_overlay_command_list; // drawn on the swapchain after post processing
 	nvrhi::BindingSetHandle m_binding_set;
 
 	std::vector<Vertex> m_vertices;
 	std::vector<u32> m_indices;
-	std::vector<glm::u8vec4> m_pixels;
+	std::vector<std::vector<glm::u8vec4>> m_texture_mips; // full chain, kept to re-upload after eviction
+	std::vector<gfx::Light> m_lights;
+
+	std::vector<Vertex> m_torus_vertices;
+	scene::MeshletData m_torus_meshlets;
+	std::vector<glm::mat4> m_torus_instances;
+	std::vector<u32> m_torus_objects; // object ids in instance order
 
 	nvrhi::BufferHandle m_constant_buffer;
 	nvrhi::BufferHandle m_vertex_buffer;
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include "types.hpp"
+
+namespace vg::gfx {
+
+// Two-level segregated fit allocator, only manages offsets into an external range (e.g. a heap)
+class TlsfAllocator {
+  public:
+	static constexpr u32 INVALID_NODE = ~0u;
+
+	struct Allocation {
+		u64 offset = 0;
+		u64 size = 0;
+		u32 node = INVALID_NODE;
+	};
+
+	explicit TlsfAllocator(u64 capacity, u64 granularity = 1);
+
+	std::optional<Allocation> allocate(u64 size, u64 alignment = 1);
+	void free(const Allocation& allocation);
+
+	u64 get_capacity() const {
+		return m_capacity;
+	}
+	u64 get_used() const {
+		return m_used;
+	}
+	bool is_empty() const {
+		return m_used == 0;
+	}
+
+  private:
+	static constexpr u32 SL_BITS = 4;
+	static constexpr u32 SL_COUNT = 1 << SL_BITS;
+	static constexpr u32 FL_COUNT = 64 - SL_BITS + 1;
+
+	struct Block {
+		u64 offset = 0;
+		u64 size = 0;
+		u32 prev_phys = INVALID_NODE;
+		u32 next_phys = INVALID_NODE;
+		u32 prev_free = INVALID_NODE;
+		u32 next_free = INVALID_NODE;
+		bool free = false;
+	};
+
+	static void mapping(u64 size, u32& fl, u32& sl);
+
+	u32 create_block(u64 offset, u64 size);
+	void destroy_block(u32 node);
+
+	void insert_free(u32 node);
+	void remove_free(u32 node);
+	u32 find_free(u64 size);
+
+	u32 split(u32 node, u64 size);
+
+	u64 m_capacity;
+	u64 m_granularity;
+	u64 m_used = 0;
+
+	std::vector<Block> m_blocks;
+	std::vector<u32> m_unused_nodes;
+
+	u64 m_fl_bitmap = 0;
+	std::array<u32, FL_COUNT> m_sl_bitmap = {};
+	std::array<std::array<u32, SL_COUNT>, FL_COUNT> m_free_heads = {};
+};
+
+} // namespace vg::gfx
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <list>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "types.hpp"
+
+namespace vg::gfx {
+
+enum class CacheType : u8 {
+	InputLayout,
+	BindingLayout,
+	Sampler,
+	BindingSet,
+	GraphicsPipeline,
+	MeshletPipeline,
+	ComputePipeline,
+	Count,
+};
+
+std::string_view to_string(CacheType type);
+
+struct CacheStats {
+	u64 hits = 0;
+	u64 misses = 0;
+	u64 evictions = 0;
+};
+
+// Interns nvrhi objects by a hash of their descriptor, so identical requests share one handle.
+// Each entry keeps a copy of its descriptor and a hit is only taken when it compares equal.
+// All getters are safe to call from multiple threads.
+class PipelineCache {
+  public:
+	static constexpr usize DEFAULT_BINDING_SET_CAPACITY = 4096;
+
+	explicit PipelineCache(nvrhi::DeviceHandle device, usize binding_set_capacity = DEFAULT_BINDING_SET_CAPACITY);
+
+	nvrhi::InputLayoutHandle get_input_layout(
+		std::span<const nvrhi::VertexAttributeDesc> attributes,
+		nvrhi::IShader* vertex_shader
+	);
+	nvrhi::BindingLayoutHandle get_binding_layout(const nvrhi::BindingLayoutDesc& desc);
+	nvrhi::SamplerHandle get_sampler(const nvrhi::SamplerDesc& desc);
+	nvrhi::BindingSetHandle get_binding_set(const nvrhi::BindingSetDesc& desc, nvrhi::IBindingLayout* layout);
+	nvrhi::GraphicsPipelineHandle get_graphics_pipeline(
+		const nvrhi::GraphicsPipelineDesc& desc,
+		const nvrhi::FramebufferInfo& framebuffer_info
+	);
+	nvrhi::MeshletPipelineHandle get_meshlet_pipeline(
+		const nvrhi::MeshletPipelineDesc& desc,
+		const nvrhi::FramebufferInfo& framebuffer_info
+	);
+	nvrhi::ComputePipelineHandle get_compute_pipeline(const nvrhi::ComputePipelineDesc& desc);
+
+	// Drops every cached binding set that references the resource, so the resource is freed once its owners let go
+	void invalidate(nvrhi::IResource* resource);
+	// Drops the binding sets nobody but the cache holds anymore, called once per frame
+	void collect();
+
+	// a copy, taken under the lock
+	CacheStats get_stats(CacheType type) const;
+
+  private:
+	template<typename Entry>
+	using Cache = std::unordered_map<u64, Entry>;
+
+	template<typename Desc, typename Handle>
+	struct Entry {
+		Desc desc;
+		Handle handle;
+	};
+
+	template<typename Desc, typename Handle>
+	struct PipelineEntry {
+		Desc desc;
+		nvrhi::FramebufferInfo framebuffer_info;
+		Handle handle;
+	};
+
+	struct InputLayoutEntry {
+		std::vector<nvrhi::VertexAttributeDesc> attributes;
+		nvrhi::ShaderHandle vertex_shader; // keeps the address used in the key alive
+		nvrhi::InputLayoutHandle handle;
+	};
+
+	struct BindingSetEntry {
+		u64 key = 0;
+		nvrhi::BindingSetDesc desc;
+		nvrhi::BindingLayoutHandle layout;
+		nvrhi::BindingSetHandle handle;
+	};
+
+	using BindingLayoutEntry = Entry<nvrhi::BindingLayoutDesc, nvrhi::BindingLayoutHandle>;
+	using SamplerEntry = Entry<nvrhi::SamplerDesc, nvrhi::SamplerHandle>;
+	using GraphicsPipelineEntry = PipelineEntry<nvrhi::GraphicsPipelineDesc, nvrhi::GraphicsPipelineHandle>;
+	using MeshletPipelineEntry = PipelineEntry<nvrhi::MeshletPipelineDesc, nvrhi::MeshletPipelineHandle>;
+	using ComputePipelineEntry = Entry<nvrhi::ComputePipelineDesc, nvrhi::ComputePipelineHandle>;
+	using BindingSetList = std::list<BindingSetEntry>;
+
+	BindingSetList::iterator erase_binding_set(BindingSetList::iterator it);
+
+	CacheStats& stats(CacheType type) {
+		return m_stats[static_cast<usize>(type)];
+	}
+
+	nvrhi::DeviceHandle m_device;
+
+	Cache<InputLayoutEntry> m_input_layouts;
+	Cache<BindingLayoutEntry> m_binding_layouts;
+	Cache<SamplerEntry> m_samplers;
+	Cache<GraphicsPipelineEntry> m_graphics_pipelines;
+	Cache<MeshletPipelineEntry> m_meshlet_pipelines;
+	Cache<ComputePipelineEntry> m_compute_pipelines;
+
+	// binding sets are the only objects created per material/draw, so they are bounded by an LRU.
+	// NOTE: a cached set keeps its resources alive, sets are dropped as soon as only the cache holds them
+	usize m_binding_set_capacity;
+	BindingSetList m_binding_set_lru;
+	Cache<BindingSetList::iterator> m_binding_sets;
+
+	std::array<CacheStats, static_cast<usize>(CacheType::Count)> m_stats = {};
+
+	mutable std::mutex m_mutex;
+};
+
+} // namespace vg::gfx
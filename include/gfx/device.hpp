@@ -3,15 +3,24 @@
 #include <SDL3/SDL.h>
 #include <nvrhi/nvrhi.h>
 
+#include <array>
 #include <memory>
 
+#include "gfx/cache.hpp"
+#include "gfx/memory.hpp"
+#include "metrics.hpp"
 #include "types.hpp"
 
 namespace vg::gfx {
 
+struct DeviceOptions {
+	// NOTE: only has an effect in debug builds, it makes device creation and every submit much slower
+	bool gpu_validation = false;
+};
+
 class IDevice : public nvrhi::IMessageCallback {
   public:
-	static std::unique_ptr<IDevice> create();
+	static std::unique_ptr<IDevice> create(const DeviceOptions& options = {});
 	~IDevice() override = default;
 
 	virtual void create_swapchain(SDL_Window* window) = 0;
@@ -28,20 +37,36 @@ class IDevice : public nvrhi::IMessageCallback {
 	virtual u32 get_buffer_count() = 0;
 	virtual nvrhi::TextureHandle get_buffer(u32 index) = 0;
 	virtual nvrhi::DeviceHandle get_device() = 0;
+	virtual MemoryBudget query_memory_budget() = 0;
+
+	MemoryManager& get_memory() {
+		return *m_memory;
+	}
+	PipelineCache& get_cache() {
+		return *m_cache;
+	}
 
 	nvrhi::FramebufferHandle begin_frame();
 	void end_frame();
 
   private: // nvrhi::IMessageCallback
 	void message(nvrhi::MessageSeverity severity, const char* text) override;
-	void create_depth_buffer(u32 width, u32 height);
 
   protected:
+	IDevice();
+
 	void create_framebuffers();
 	void destroy_framebuffers();
+	void destroy_resources();
 
+	std::unique_ptr<MemoryManager> m_memory;
+	std::unique_ptr<PipelineCache> m_cache;
 	std::vector<nvrhi::FramebufferHandle> m_framebuffers;
-	nvrhi::TextureHandle m_depth_texture;
+
+	u64 m_frame_index = 0; // frames presented so far, advanced by end_frame
+
+	// NOTE: resolved once per severity, the message callback only adds to them and never takes the registry lock
+	std::array<Counter*, 4> m_message_counters = {};
 };
 
 } // namespace vg::gfx
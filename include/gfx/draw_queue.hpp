@@ -0,0 +1,88 @@
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "gfx/radix_sort.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+enum class DrawLayer : u8 {
+	Scene,
+	Overlay,
+};
+
+struct DrawItem {
+	static constexpr u32 MAX_BINDING_SETS = 4;
+	static constexpr u32 MAX_PUSH_CONSTANTS = 128;
+
+	// NOTE: resources are borrowed, the caller keeps them alive until the queue is flushed
+	nvrhi::IGraphicsPipeline* pipeline = nullptr;
+	std::array<nvrhi::IBindingSet*, MAX_BINDING_SETS> binding_sets = {};
+	nvrhi::IBuffer* vertex_buffer = nullptr;
+	nvrhi::IBuffer* index_buffer = nullptr;
+	nvrhi::Format index_format = nvrhi::Format::R32_UINT;
+
+	nvrhi::DrawArguments args;
+
+	// when set, args is ignored and indirect_count draws are read from indirect_buffer at indirect_offset
+	nvrhi::IBuffer* indirect_buffer = nullptr;
+	u32 indirect_offset = 0;
+	u32 indirect_count = 0;
+
+	std::array<std::byte, MAX_PUSH_CONSTANTS> push_constants = {};
+	u32 push_constants_size = 0;
+
+	template<typename T>
+	void set_push_constants(const T& value) {
+		static_assert(sizeof(T) <= MAX_PUSH_CONSTANTS);
+		std::memcpy(push_constants.data(), &value, sizeof(T));
+		push_constants_size = sizeof(T);
+	}
+};
+
+struct DrawQueueStats {
+	u32 draws = 0;
+	u32 state_changes = 0; // setGraphicsState calls actually issued
+	u32 state_changes_skipped = 0; // draws that reused the previous state
+};
+
+// Collects draws for one framebuffer, sorts them by a 64-bit key and submits them with minimal state changes.
+// Key layout (msb to lsb): layer 4 | translucent 1 | pipeline 16 | material 16 | depth 27
+// translucent draws move depth to the top of the low bits, inverted, so they sort back to front
+class DrawQueue {
+  public:
+	explicit DrawQueue(ThreadPool* thread_pool = nullptr);
+
+	void begin(nvrhi::IFramebuffer* framebuffer, const nvrhi::ViewportState& viewport);
+	void submit(const DrawItem& item, DrawLayer layer, bool translucent, f32 depth);
+	void flush(nvrhi::ICommandList* command_list);
+
+	const DrawQueueStats& get_stats() const {
+		return m_stats;
+	}
+
+  private:
+	u16 get_id(std::unordered_map<const void*, u16>& ids, const void* object);
+
+	RadixSort m_sort;
+
+	nvrhi::IFramebuffer* m_framebuffer = nullptr;
+	nvrhi::ViewportState m_viewport;
+
+	std::vector<DrawItem> m_items;
+	std::vector<SortEntry> m_entries;
+
+	std::unordered_map<const void*, u16> m_pipeline_ids;
+	std::unordered_map<const void*, u16> m_material_ids;
+
+	DrawQueueStats m_stats;
+};
+
+} // namespace vg::gfx
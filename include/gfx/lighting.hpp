@@ -0,0 +1,105 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <span>
+
+#include "gfx/device.hpp"
+#include "metrics.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+enum class LightType : u32 {
+	Point,
+	Spot,
+};
+
+// NOTE: must match the Light struct in shaders/lighting.hlsli
+struct Light {
+	glm::vec3 position = {};
+	f32 range = 1.f;
+	glm::vec3 color = glm::vec3(1.f);
+	f32 intensity = 1.f;
+	glm::vec3 direction = glm::vec3(0.f, -1.f, 0.f);
+	f32 spot_outer = 0.f; // cosine of the outer cone angle
+	f32 spot_inner = 0.f; // cosine of the inner cone angle
+	LightType type = LightType::Point;
+	f32 padding[2] = {};
+};
+
+static_assert(sizeof(Light) == 64);
+
+struct LightingStats {
+	u32 lights = 0; // binned this frame
+	u32 dropped_lights = 0; // past MAX_LIGHTS, never uploaded
+	u32 full_clusters = 0; // clusters that hit MAX_LIGHTS_PER_CLUSTER
+	u32 dropped_cluster_lights = 0; // lights those clusters had no room for
+};
+
+// Bins lights into a froxel grid on the gpu so shading only loops over lights touching a pixel's cluster
+class ClusteredLighting {
+  public:
+	static constexpr u32 CLUSTER_X = 16;
+	static constexpr u32 CLUSTER_Y = 9;
+	static constexpr u32 CLUSTER_Z = 24;
+	static constexpr u32 CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+	static constexpr u32 MAX_LIGHTS = 4096;
+	static constexpr u32 MAX_LIGHTS_PER_CLUSTER = 128;
+	static constexpr u32 GROUP_SIZE = 64;
+	static constexpr u32 READBACK_LATENCY = 4;
+
+	ClusteredLighting(IDevice& device, nvrhi::ShaderHandle binning_shader);
+
+	// Lights past MAX_LIGHTS are dropped, the stats report them along with clusters that ran out of room
+	void update(
+		nvrhi::ICommandList* command_list,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		f32 near_plane,
+		f32 far_plane,
+		u32 width,
+		u32 height,
+		std::span<const Light> lights
+	);
+
+	nvrhi::BindingLayoutHandle get_binding_layout() const {
+		return m_binding_layout;
+	}
+	nvrhi::BindingSetHandle get_binding_set() const {
+		return m_binding_set;
+	}
+
+	// NOTE: the cluster overflow counts lag READBACK_LATENCY frames behind
+	const LightingStats& get_stats() const {
+		return m_stats;
+	}
+
+  private:
+	nvrhi::BufferHandle m_params_buffer;
+	nvrhi::BufferHandle m_light_buffer;
+	nvrhi::BufferHandle m_cluster_buffer;
+	nvrhi::BufferHandle m_index_buffer;
+	nvrhi::BufferHandle m_overflow_buffer;
+
+	nvrhi::ComputePipelineHandle m_binning_pipeline;
+	nvrhi::BindingSetHandle m_binning_set;
+
+	nvrhi::BindingLayoutHandle m_binding_layout;
+	nvrhi::BindingSetHandle m_binding_set;
+
+	nvrhi::DeviceHandle m_device;
+	std::array<nvrhi::BufferHandle, READBACK_LATENCY> m_readback;
+	u64 m_frame = 0;
+
+	LightingStats m_stats;
+	Counter& m_upload_bytes;
+};
+
+} // namespace vg::gfx
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "gfx/allocator.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+class IDevice;
+
+enum class MemoryCategory : u8 {
+	Geometry,
+	Texture,
+	RenderTarget,
+	Constant,
+	Streamed, // re-uploadable from the cpu at any time: per frame uploads, readbacks and evictable textures
+	Scratch, // written and read by the gpu only, e.g. light lists or indirect arguments
+	Count,
+};
+
+struct MemoryBudget {
+	u64 budget = 0;
+	u64 usage = 0;
+};
+
+struct MemoryStats {
+	std::array<u64, static_cast<usize>(MemoryCategory::Count)> category_bytes = {};
+	u64 heap_bytes = 0; // reserved from the driver
+	u64 allocated_bytes = 0; // handed out to resources
+	u32 heap_count = 0;
+	u32 allocation_count = 0;
+	u32 evicted_count = 0; // evicted resources whose memory was actually freed
+	u64 evicted_bytes = 0;
+	MemoryBudget budget;
+};
+
+// Places buffers and textures into large heaps instead of giving each one a committed allocation.
+// Allocations are reclaimed automatically once the manager holds the last reference to a resource.
+// Resources can be created from any thread.
+class MemoryManager {
+  public:
+	static constexpr u64 DEFAULT_HEAP_SIZE = 256ull << 20;
+
+	explicit MemoryManager(IDevice& device, u64 heap_size = DEFAULT_HEAP_SIZE);
+	~MemoryManager();
+
+	MemoryManager(const MemoryManager&) = delete;
+	MemoryManager& operator=(const MemoryManager&) = delete;
+
+	nvrhi::BufferHandle create_buffer(nvrhi::BufferDesc desc, MemoryCategory category);
+	nvrhi::TextureHandle create_texture(nvrhi::TextureDesc desc, MemoryCategory category);
+
+	// Called when nearing the budget, the owner should drop or replace the resource. Only streamed resources
+	// can be evicted, cached binding sets referencing the resource are dropped before the callback runs
+	void set_eviction_callback(nvrhi::IResource* resource, std::function<void()> callback);
+	// Marks the resource as used this frame, eviction picks the least recently touched resources first
+	void touch(nvrhi::IResource* resource);
+
+	void update(u64 frame);
+
+	// a copy, taken under the lock
+	MemoryStats get_stats() const;
+
+  private:
+	static constexpr f64 EVICTION_THRESHOLD = 0.9;
+	static constexpr f64 EVICTION_TARGET = 0.8;
+	static constexpr u64 HEAP_ALIGNMENT = 64ull << 10;
+
+	enum class HeapClass : u8 {
+		Buffer,
+		Texture,
+		RenderTarget,
+		Count,
+	};
+
+	struct Heap {
+		nvrhi::HeapHandle handle;
+		TlsfAllocator allocator;
+		bool dedicated = false;
+	};
+
+	struct Allocation {
+		nvrhi::ResourceHandle resource;
+		Heap* heap = nullptr; // null for volatile buffers, they live in nvrhi's upload ring
+		TlsfAllocator::Allocation range;
+		MemoryCategory category = MemoryCategory::Geometry;
+		u64 last_used = 0;
+		std::function<void()> evict;
+		bool evicted = false; // the callback ran, the memory counts as evicted once it is freed
+	};
+
+	struct PendingFree {
+		Heap* heap = nullptr;
+		TlsfAllocator::Allocation range;
+		u64 frame = 0;
+	};
+
+	using Pool = std::vector<std::unique_ptr<Heap>>;
+
+	Pool& get_pool(nvrhi::HeapType type, HeapClass heap_class);
+	std::pair<Heap*, TlsfAllocator::Allocation> allocate(
+		nvrhi::HeapType type,
+		HeapClass heap_class,
+		const nvrhi::MemoryRequirements& requirements
+	);
+
+	void track(nvrhi::IResource* resource, Heap* heap, const TlsfAllocator::Allocation& range, MemoryCategory category);
+	void collect();
+	void evict(u64 bytes);
+	void release_empty_heaps();
+
+	IDevice& m_device;
+	u64 m_heap_size;
+	u64 m_frame = 0;
+
+	std::array<Pool, 3 * static_cast<usize>(HeapClass::Count)> m_pools;
+	std::unordered_map<nvrhi::IResource*, Allocation> m_allocations;
+	std::vector<PendingFree> m_pending_frees;
+	u64 m_evicting_bytes = 0; // evicted but still referenced by their owners
+
+	MemoryStats m_stats;
+
+	// NOTE: recursive since eviction callbacks usually create a replacement resource
+	mutable std::recursive_mutex m_mutex;
+};
+
+} // namespace vg::gfx
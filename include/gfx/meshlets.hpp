@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <span>
+
+#include "gfx/device.hpp"
+#include "gfx/draw_queue.hpp"
+#include "metrics.hpp"
+#include "scene/meshlet.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+// NOTE: must match the Meshlet struct in shaders/meshlet.hlsli
+struct GpuMeshlet {
+	glm::vec4 sphere; // center, radius
+	glm::vec4 cone_apex; // w unused
+	glm::vec4 cone_axis; // axis, cutoff
+	glm::uvec4 ranges; // vertex offset, triangle offset, vertex count, triangle count
+};
+
+static_assert(sizeof(GpuMeshlet) == 64);
+
+struct MeshletStats {
+	u32 meshlets = 0;
+	u32 visible_meshlets = 0;
+	u32 triangles = 0;
+	u32 visible_triangles = 0;
+};
+
+// Gpu side of a mesh split into meshlets, culled per meshlet and instance against the frustum and normal cones.
+// Without mesh shaders a compute pass writes one indexed indirect draw per meshlet and instance, culled
+// meshlets get an instance count of zero. With them the amplification shader culls and launches a mesh
+// shader group per surviving meshlet instead.
+class MeshletMesh {
+  public:
+	static constexpr u32 MAX_INSTANCES = 256;
+	static constexpr u32 CULL_GROUP_SIZE = 64;
+	static constexpr u32 TASK_GROUP_SIZE = 32;
+	static constexpr u32 READBACK_LATENCY = 4;
+
+	MeshletMesh(
+		IDevice& device,
+		nvrhi::ShaderHandle cull_shader,
+		const scene::MeshletData& data,
+		u32 vertex_count,
+		u32 vertex_stride
+	);
+
+	static bool supports_mesh_shaders(IDevice& device);
+
+	void upload(nvrhi::ICommandList* command_list, const scene::MeshletData& data, std::span<const std::byte> vertices);
+
+	// Writes this frame's cull parameters and instance transforms, instances past MAX_INSTANCES are dropped
+	void update(
+		nvrhi::ICommandList* command_list,
+		const glm::mat4& view_projection,
+		const glm::vec3& camera_position,
+		std::span<const glm::mat4> instances
+	);
+
+	// Writes the indirect arguments for every instance passed to update
+	void cull(nvrhi::ICommandList* command_list);
+
+	// Copies the visibility counters, call once all draws are recorded. Stats lag READBACK_LATENCY frames behind
+	void resolve_stats(nvrhi::ICommandList* command_list);
+
+	// Geometry and indirect arguments for one instance, the caller adds pipeline, bindings and push constants
+	DrawItem get_draw_item(u32 instance) const;
+
+	u32 get_task_group_count() const {
+		return (m_meshlet_count + TASK_GROUP_SIZE - 1) / TASK_GROUP_SIZE;
+	}
+	u32 get_instance_count() const {
+		return m_instance_count;
+	}
+
+	// space2 bindings of the mesh shader path, null when the device has no mesh shaders
+	nvrhi::BindingLayoutHandle get_binding_layout() const {
+		return m_binding_layout;
+	}
+	nvrhi::BindingSetHandle get_binding_set() const {
+		return m_binding_set;
+	}
+
+	const MeshletStats& get_stats() const {
+		return m_stats;
+	}
+
+  private:
+	u32 m_meshlet_count = 0;
+	u32 m_triangle_count = 0;
+	u32 m_instance_count = 0;
+
+	nvrhi::BufferHandle m_vertex_buffer;
+	nvrhi::BufferHandle m_index_buffer;
+	nvrhi::BufferHandle m_meshlet_buffer;
+	nvrhi::BufferHandle m_meshlet_vertex_buffer;
+	nvrhi::BufferHandle m_meshlet_triangle_buffer;
+
+	nvrhi::BufferHandle m_params_buffer;
+	nvrhi::BufferHandle m_instance_buffer;
+	nvrhi::BufferHandle m_argument_buffer;
+	nvrhi::BufferHandle m_counter_buffer;
+
+	nvrhi::ComputePipelineHandle m_cull_pipeline;
+	nvrhi::BindingSetHandle m_cull_set;
+
+	nvrhi::BindingLayoutHandle m_binding_layout;
+	nvrhi::BindingSetHandle m_binding_set;
+
+	nvrhi::DeviceHandle m_device;
+	std::array<nvrhi::BufferHandle, READBACK_LATENCY> m_readback;
+	std::array<u32, READBACK_LATENCY> m_readback_instances = {};
+	u64 m_frame = 0;
+
+	MeshletStats m_stats;
+	Counter& m_upload_bytes;
+};
+
+} // namespace vg::gfx
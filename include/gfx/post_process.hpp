@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include <nvrhi/nvrhi.h>
+
+#include <array>
+#include <initializer_list>
+#include <vector>
+
+#include "gfx/device.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+struct PostProcessShaders {
+	nvrhi::ShaderHandle taa;
+	nvrhi::ShaderHandle bloom_downsample;
+	nvrhi::ShaderHandle bloom_upsample;
+	nvrhi::ShaderHandle tonemap;
+};
+
+struct PostProcessSettings {
+	bool taa = true;
+	f32 taa_blend = 0.1f; // weight of the current frame
+
+	bool bloom = true;
+	f32 bloom_threshold = 1.f;
+	f32 bloom_knee = 0.5f;
+	f32 bloom_radius = 1.f;
+	f32 bloom_intensity = 0.05f;
+
+	f32 exposure = 1.f;
+};
+
+// Owns the hdr scene targets and runs taa, bloom and tonemapping as compute passes.
+// When the device has a compute queue the passes for frame N run there while the graphics queue
+// renders frame N+1, and frame N is copied to the swapchain one frame later. Without one everything
+// is submitted serially on the graphics queue.
+class PostProcess {
+  public:
+	static constexpr u32 FRAME_COUNT = 2;
+	static constexpr u32 BLOOM_LEVELS = 6;
+	static constexpr u32 GROUP_SIZE = 8;
+	static constexpr u32 JITTER_SAMPLES = 8;
+
+	static constexpr nvrhi::Format COLOR_FORMAT = nvrhi::Format::RGBA16_FLOAT;
+	static constexpr nvrhi::Format DEPTH_FORMAT = nvrhi::Format::D32;
+
+	PostProcess(IDevice& device, const PostProcessShaders& shaders);
+
+	// Returns the framebuffer the scene should be rendered into this frame
+	nvrhi::IFramebuffer* begin_frame(u32 width, u32 height);
+
+	// Offsets the projection by this frame's sub-pixel jitter
+	glm::mat4 jitter(const glm::mat4& projection) const;
+
+	// Executes the scene commands, then schedules post processing and the copy into target.
+	// view_projection must be unjittered, it is used to reproject the history
+	void execute(nvrhi::ICommandList* scene_commands, const glm::mat4& view_projection, nvrhi::IFramebuffer* target);
+
+	PostProcessSettings& get_settings() {
+		return m_settings;
+	}
+	bool is_async() const {
+		return m_async;
+	}
+
+  private:
+	struct Pass {
+		nvrhi::BindingLayoutHandle layout;
+		nvrhi::ComputePipelineHandle pipeline;
+	};
+
+	struct Frame {
+		nvrhi::TextureHandle color;
+		nvrhi::TextureHandle depth;
+		nvrhi::TextureHandle output;
+		nvrhi::FramebufferHandle framebuffer;
+
+		nvrhi::BindingSetHandle taa_set;
+		nvrhi::BindingSetHandle tonemap_set;
+		nvrhi::BindingSetHandle downsample_set; // first bloom level reads this frame's taa output
+
+		u64 instance = 0; // compute submission that produced output
+	};
+
+	Pass create_pass(nvrhi::IShader* shader, u32 srv_count, u32 uav_count);
+	nvrhi::BindingSetHandle create_binding_set(
+		const Pass& pass,
+		std::initializer_list<nvrhi::ITexture*> srvs,
+		std::initializer_list<nvrhi::ITexture*> uavs
+	);
+
+	void create_targets(u32 width, u32 height);
+	void record(Frame& frame, const glm::mat4& view_projection);
+
+	IDevice& m_device;
+	PostProcessSettings m_settings;
+	bool m_async = false;
+
+	Pass m_taa;
+	Pass m_downsample;
+	Pass m_upsample;
+	Pass m_tonemap;
+
+	nvrhi::CommandListHandle m_compute_list;
+	nvrhi::CommandListHandle m_handoff_list; // graphics side transitions of the scene targets
+	nvrhi::CommandListHandle m_composite_list;
+
+	u32 m_width = 0;
+	u32 m_height = 0;
+
+	std::array<Frame, FRAME_COUNT> m_frames;
+	std::array<nvrhi::TextureHandle, FRAME_COUNT> m_history;
+
+	std::vector<nvrhi::TextureHandle> m_bloom;
+	std::vector<nvrhi::BindingSetHandle> m_downsample_sets; // level i - 1 into level i, index 0 unused
+	std::vector<nvrhi::BindingSetHandle> m_upsample_sets; // level i + 1 into level i
+
+	glm::mat4 m_previous_view_projection = glm::mat4(1.f);
+	u64 m_frame = 0;
+	u64 m_history_frames = 0; // frames accumulated since the targets were created
+};
+
+} // namespace vg::gfx
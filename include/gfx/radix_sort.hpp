@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+struct SortEntry {
+	u64 key;
+	u32 index;
+};
+
+// Stable LSD radix sort by key. Scratch memory is kept between calls so sorting every frame doesn't allocate,
+// inputs past PARALLEL_THRESHOLD are histogrammed and scattered in blocks across the thread pool.
+class RadixSort {
+  public:
+	static constexpr usize PARALLEL_THRESHOLD = 4096;
+
+	explicit RadixSort(ThreadPool* thread_pool = nullptr);
+
+	void sort(std::span<SortEntry> entries);
+
+  private:
+	ThreadPool* m_thread_pool;
+
+	std::vector<SortEntry> m_scratch;
+	std::vector<std::array<usize, 256>> m_histograms;
+};
+
+} // namespace vg::gfx
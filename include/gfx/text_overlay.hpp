@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+
+#include <nvrhi/nvrhi.h>
+
+#include <string_view>
+#include <vector>
+
+#include "gfx/device.hpp"
+#include "gfx/draw_queue.hpp"
+#include "metrics.hpp"
+#include "types.hpp"
+
+namespace vg::gfx {
+
+// NOTE: must match the Glyph struct in shaders/text_overlay.hlsl
+struct GpuGlyph {
+	glm::vec4 rect; // x, y, width, height in pixels
+	u32 bits; // 3x5 cells, bit = row * 3 + column, row 0 at the top
+	u32 color; // rgba8, r in the low byte
+	u32 padding[2];
+};
+
+static_assert(sizeof(GpuGlyph) == 32);
+
+// Lines of debug text in the top left corner, on a translucent panel.
+// Glyphs come from a built-in 3x5 bitmask font covering printable ascii, lowercase is drawn as uppercase.
+// Every glyph is a quad expanded from SV_VertexID, so the whole overlay is a single draw on the overlay layer.
+class TextOverlay {
+  public:
+	static constexpr u32 MAX_GLYPHS = 4096;
+	static constexpr u32 CELL_SIZE = 2; // pixels per font cell
+	static constexpr u32 MARGIN = 8; // pixels between the panel and the screen edge
+
+	static constexpr u32 WHITE = 0xffffffff;
+	static constexpr u32 YELLOW = 0xff40e0ff;
+	static constexpr u32 RED = 0xff4040ff;
+
+	TextOverlay(IDevice& device, nvrhi::ShaderHandle vertex_shader, nvrhi::ShaderHandle pixel_shader);
+
+	// Lines stay on screen until cleared, so the text only has to be rebuilt when it changes
+	void clear();
+	void add_line(std::string_view text, u32 color = WHITE);
+
+	// Uploads the glyphs if they changed and queues the overlay draw, queue must have been begun on framebuffer
+	void submit(nvrhi::ICommandList* command_list, DrawQueue& queue, nvrhi::IFramebuffer* framebuffer);
+
+  private:
+	IDevice& m_device;
+
+	nvrhi::BufferHandle m_glyph_buffer;
+	nvrhi::BindingLayoutHandle m_binding_layout;
+	nvrhi::BindingSetHandle m_binding_set;
+	nvrhi::GraphicsPipelineDesc m_pipeline_desc;
+	nvrhi::GraphicsPipelineHandle m_pipeline;
+	nvrhi::FramebufferInfo m_framebuffer_info; // the pipeline was created for
+
+	std::vector<GpuGlyph> m_glyphs; // the first one is the background panel
+	u32 m_line_count = 0;
+	u32 m_columns = 0; // characters in the longest line
+	bool m_dirty = false; // glyphs changed since the last upload
+
+	Counter& m_upload_bytes;
+};
+
+} // namespace vg::gfx
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "types.hpp"
+
+namespace vg {
+
+// NOTE: recording has to stay lock-free, so instrumentation can stay enabled in release builds
+static_assert(std::atomic<u64>::is_always_lock_free && std::atomic<f64>::is_always_lock_free);
+
+enum class MetricKind : u8 {
+	Counter,
+	Gauge,
+	Histogram,
+};
+
+// Monotonic count, e.g. draw calls or uploaded bytes
+class Counter {
+  public:
+	void add(const u64 value = 1) {
+		m_value.fetch_add(value, std::memory_order_relaxed);
+	}
+
+	u64 get() const {
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+  private:
+	std::atomic<u64> m_value = 0;
+};
+
+// Last written value, e.g. memory usage
+class Gauge {
+  public:
+	void set(const f64 value) {
+		m_value.store(value, std::memory_order_relaxed);
+	}
+
+	f64 get() const {
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+  private:
+	std::atomic<f64> m_value = 0.0;
+};
+
+struct HistogramSnapshot {
+	std::span<const f64> bounds; // upper bound of each bucket, points into the histogram
+	std::vector<u64> counts; // bounds.size() + 1 buckets, the last one is unbounded
+	u64 count = 0;
+	f64 sum = 0.0;
+
+	// Estimated by interpolating inside the bucket that holds the quantile
+	f64 percentile(f64 quantile) const;
+
+	f64 mean() const {
+		return count > 0 ? sum / static_cast<f64>(count) : 0.0;
+	}
+
+	// Samples recorded after previous was taken
+	HistogramSnapshot since(const HistogramSnapshot& previous) const;
+};
+
+// Distribution over fixed buckets, e.g. frame times
+class Histogram {
+  public:
+	explicit Histogram(std::span<const f64> bounds);
+
+	// count bounds growing geometrically from first, for values spanning several orders of magnitude
+	static std::vector<f64> exponential_bounds(f64 first, f64 factor, u32 count);
+
+	void record(f64 value);
+
+	// NOTE: buckets are read one by one, a snapshot taken during record() can be off by that one sample
+	HistogramSnapshot snapshot() const;
+
+  private:
+	std::vector<f64> m_bounds;
+	std::vector<std::atomic<u64>> m_counts;
+	std::atomic<u64> m_count = 0;
+	std::atomic<f64> m_sum = 0.0;
+};
+
+struct MetricSnapshot {
+	std::string_view name;
+	std::string_view tags; // line protocol tag set, e.g. "type=binding_set"
+	MetricKind kind = MetricKind::Counter;
+
+	u64 count = 0; // counters
+	f64 value = 0.0; // gauges
+	HistogramSnapshot histogram; // histograms
+};
+
+struct MetricsSnapshot {
+	std::chrono::system_clock::time_point time;
+	std::vector<MetricSnapshot> metrics; // in registration order, so indices stay valid between snapshots
+};
+
+// Owns named metrics that any thread can record into.
+// Registering takes a lock and returns a reference that stays valid for the life of the registry,
+// recording through it is a relaxed atomic operation and never blocks. Look metrics up once and keep
+// the reference, registering the same name and tags again returns the existing metric.
+class MetricsRegistry {
+  public:
+	static MetricsRegistry& global();
+
+	Counter& counter(std::string_view name, std::string_view tags = {});
+	Gauge& gauge(std::string_view name, std::string_view tags = {});
+	Histogram& histogram(std::string_view name, std::span<const f64> bounds, std::string_view tags = {});
+
+	MetricsSnapshot snapshot() const;
+
+  private:
+	struct Entry {
+		std::string name;
+		std::string tags;
+		MetricKind kind;
+		void* metric;
+	};
+
+	template<typename T, typename... Args>
+	T& get_or_create(
+		std::vector<std::unique_ptr<T>>& storage,
+		MetricKind kind,
+		std::string_view name,
+		std::string_view tags,
+		Args&&... args
+	);
+
+	std::vector<std::unique_ptr<Counter>> m_counters;
+	std::vector<std::unique_ptr<Gauge>> m_gauges;
+	std::vector<std::unique_ptr<Histogram>> m_histograms;
+
+	std::deque<Entry> m_entries; // stable addresses, snapshots refer to the names
+	std::unordered_map<std::string, usize> m_lookup; // name and tags to entry index
+
+	mutable std::mutex m_mutex;
+};
+
+} // namespace vg
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "metrics.hpp"
+#include "types.hpp"
+
+namespace vg {
+
+struct MetricsExportOptions {
+	std::string file; // appended to, empty to disable
+	std::string udp; // host:port, empty to disable
+	std::chrono::milliseconds interval {1000};
+};
+
+// Snapshots a registry on its own thread and writes it as influxdb line protocol:
+//   <name>,app=vanguard[,<tags>] <fields> <unix time in ns>
+// Counters and gauges write a single value field. Histograms write count, sum, mean and percentiles
+// of the samples recorded since the previous export, and are skipped when there were none.
+class MetricsExporter {
+  public:
+	static constexpr usize MAX_DATAGRAM_SIZE = 1400; // stays below a typical mtu
+
+	MetricsExporter(MetricsRegistry& registry, MetricsExportOptions options);
+	~MetricsExporter();
+
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+	static std::string format(const MetricsSnapshot& snapshot, const MetricsSnapshot& previous);
+
+  private:
+	struct UdpSink;
+
+	void run(const std::stop_token& stop);
+	void write(const std::string& lines);
+
+	MetricsRegistry& m_registry;
+	MetricsExportOptions m_options;
+
+	std::ofstream m_file;
+	std::unique_ptr<UdpSink> m_udp;
+	MetricsSnapshot m_previous;
+
+	std::mutex m_mutex;
+	std::condition_variable_any m_condition;
+
+	// NOTE: last, the thread starts once everything above is initialized
+	std::jthread m_thread;
+};
+
+} // namespace vg
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/vector_relational.hpp>
+
+#include <array>
+#include <limits>
+
+#include "types.hpp"
+
+namespace vg::scene {
+
+struct AABB {
+	glm::vec3 min = glm::vec3(std::numeric_limits<f32>::max());
+	glm::vec3 max = glm::vec3(std::numeric_limits<f32>::lowest());
+
+	static AABB merge(const AABB& a, const AABB& b) {
+		return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+	}
+
+	void grow(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	bool contains(const AABB& other) const {
+		return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+	}
+
+	glm::vec3 center() const {
+		return (min + max) * 0.5f;
+	}
+
+	f32 surface_area() const {
+		const glm::vec3 d = glm::max(max - min, glm::vec3(0.f));
+		return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	AABB transform(const glm::mat4& matrix) const;
+};
+
+struct Sphere {
+	glm::vec3 center = {};
+	f32 radius = 0.f;
+};
+
+struct Ray {
+	glm::vec3 origin = {};
+	glm::vec3 direction = glm::vec3(0.f, 0.f, -1.f);
+	f32 t_max = std::numeric_limits<f32>::max();
+};
+
+// Planes point inwards, a point is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them
+struct Frustum {
+	std::array<glm::vec4, 6> planes = {};
+
+	// NOTE: expects a zero to one depth range
+	static Frustum from_matrix(const glm::mat4& view_projection);
+};
+
+} // namespace vg::scene
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "scene/bounds.hpp"
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+namespace vg::scene {
+
+struct RayHit {
+	u32 user_data = std::numeric_limits<u32>::max();
+	f32 t = std::numeric_limits<f32>::max();
+
+	bool hit() const {
+		return user_data != std::numeric_limits<u32>::max();
+	}
+};
+
+// Dynamic bounding volume hierarchy over object AABBs.
+// Edits happen on a binary tree (SAH insertion, refit with tree rotations), queries run on a
+// flattened 4-wide copy in SoA layout. Updates refit the copy in place, it is only rebuilt lazily after
+// inserts, removals or rotations change the topology.
+class Bvh {
+  public:
+	static constexpr u32 INVALID = std::numeric_limits<u32>::max();
+
+	explicit Bvh(ThreadPool* thread_pool = nullptr);
+
+	u32 insert(const AABB& bounds, u32 user_data);
+	void remove(u32 proxy);
+	void update(u32 proxy, const AABB& bounds);
+
+	// Full top-down binned SAH rebuild, useful after bulk loading or many updates
+	void rebuild();
+
+	void query_frustum(const Frustum& frustum, std::vector<u32>& results);
+	void query_sphere(const Sphere& sphere, std::vector<u32>& results);
+	RayHit raycast(const Ray& ray);
+
+	// Batched variants run one query per element, spread across the thread pool when there is one
+	void query_frustums(std::span<const Frustum> frustums, std::span<std::vector<u32>> results);
+	void query_spheres(std::span<const Sphere> spheres, std::span<std::vector<u32>> results);
+	void raycast(std::span<const Ray> rays, std::span<RayHit> hits);
+
+	u32 get_proxy_count() const {
+		return m_proxy_count;
+	}
+	f32 get_cost() const;
+
+  private:
+	struct Node {
+		AABB bounds;
+		u32 parent = INVALID;
+		u32 left = INVALID;
+		u32 right = INVALID;
+		u32 proxy = INVALID; // only set for leaves
+		u32 wide = INVALID; // wide node holding these bounds, unset for nodes opened while flattening
+		u32 slot = 0;
+
+		bool is_leaf() const {
+			return left == INVALID;
+		}
+	};
+
+	struct Proxy {
+		AABB bounds;
+		u32 user_data = INVALID;
+		u32 leaf = INVALID;
+	};
+
+	// four children per node, bounds stored per axis so one SSE register tests all of them
+	struct alignas(16) WideNode {
+		static constexpr u32 LEAF = 1u << 31;
+		static constexpr u32 EMPTY = INVALID;
+
+		f32 min_x[4];
+		f32 min_y[4];
+		f32 min_z[4];
+		f32 max_x[4];
+		f32 max_y[4];
+		f32 max_z[4];
+		u32 children[4]; // node index, LEAF | user data, or EMPTY
+	};
+
+	u32 allocate_node();
+	void free_node(u32 node);
+
+	void insert_leaf(u32 leaf);
+	void remove_leaf(u32 leaf);
+	bool refit(u32 node); // true if a rotation changed the topology
+	void refit_wide(u32 node);
+	bool rotate(u32 node);
+
+	u32 build_recursive(std::span<u32> leaves);
+
+	void flatten();
+	u32 flatten_recursive(u32 node);
+
+	RayHit trace(const Ray& ray) const;
+
+	template<typename Test, typename Leaf>
+	void traverse(Test&& test, Leaf&& leaf) const;
+
+	ThreadPool* m_thread_pool;
+
+	std::vector<Node> m_nodes;
+	std::vector<u32> m_free_nodes;
+	u32 m_root = INVALID;
+
+	std::vector<Proxy> m_proxies;
+	std::vector<u32> m_free_proxies;
+	u32 m_proxy_count = 0;
+
+	std::vector<WideNode> m_wide_nodes;
+	bool m_dirty = true;
+};
+
+} // namespace vg::scene
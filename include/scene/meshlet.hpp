@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <span>
+#include <vector>
+
+#include "types.hpp"
+
+namespace vg::scene {
+
+struct Meshlet {
+	u32 vertex_offset = 0; // into MeshletData::vertices
+	u32 triangle_offset = 0; // into MeshletData::triangles
+	u32 vertex_count = 0;
+	u32 triangle_count = 0;
+};
+
+struct MeshletBounds {
+	glm::vec3 center = {};
+	f32 radius = 0.f;
+
+	// the meshlet is backfacing when dot(normalize(cone_apex - camera), cone_axis) >= cone_cutoff
+	glm::vec3 cone_apex = {};
+	glm::vec3 cone_axis = {};
+	f32 cone_cutoff = 1.f; // 1 when the normals spread too far for the test to be useful
+};
+
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> bounds;
+	std::vector<u32> vertices; // meshlet local to mesh vertex index
+	std::vector<u32> triangles; // three meshlet local 8-bit indices packed per triangle
+	std::vector<u32> indices; // triangles as mesh vertex indices in meshlet order, for indexed draws
+
+	u32 get_triangle_count() const {
+		return static_cast<u32>(triangles.size());
+	}
+};
+
+// Splits an indexed triangle list into clusters of up to MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+// Triangles are grown greedily from shared vertices so clusters stay spatially compact, which keeps their
+// bounding spheres small and their normal cones narrow enough to cull.
+class MeshletBuilder {
+  public:
+	static constexpr u32 MAX_VERTICES = 64;
+	static constexpr u32 MAX_TRIANGLES = 124;
+
+	static MeshletData build(std::span<const glm::vec3> positions, std::span<const u32> indices);
+
+  private:
+	static MeshletBounds compute_bounds(
+		std::span<const glm::vec3> positions,
+		std::span<const u32> indices,
+		std::span<const u32> triangles
+	);
+};
+
+} // namespace vg::scene
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+namespace vg {
+
+struct TaskTiming {
+	std::string_view name;
+	f64 start_ms = 0.0; // relative to the start of the graph
+	f64 duration_ms = 0.0;
+	bool main_thread = false;
+};
+
+// Runs a set of tasks on the thread pool as soon as their dependencies have finished.
+// Tasks marked as main thread only run on the thread that calls run(), for apis with thread affinity.
+class TaskGraph {
+  public:
+	using TaskId = u32;
+
+	explicit TaskGraph(ThreadPool& thread_pool);
+
+	TaskId add(std::string name, std::function<void()> fn, std::initializer_list<TaskId> dependencies = {});
+	TaskId add_main(std::string name, std::function<void()> fn, std::initializer_list<TaskId> dependencies = {});
+
+	// Blocks until every task has finished and rethrows the first exception a task threw.
+	// Once a task has thrown, tasks that haven't started yet are skipped.
+	void run();
+
+	std::vector<TaskTiming> get_timings() const;
+	void report() const;
+
+  private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Task {
+		std::string name;
+		std::function<void()> fn;
+		bool main_thread = false;
+
+		std::vector<TaskId> dependents;
+		u32 dependency_count = 0;
+		std::atomic<u32> remaining = 0;
+
+		Clock::time_point start;
+		Clock::time_point end;
+	};
+
+	TaskId add_task(
+		std::string name,
+		std::function<void()> fn,
+		bool main_thread,
+		std::initializer_list<TaskId> dependencies
+	);
+
+	void schedule(TaskId id);
+	void execute(TaskId id);
+
+	ThreadPool& m_thread_pool;
+	std::vector<std::unique_ptr<Task>> m_tasks;
+
+	Clock::time_point m_start;
+	Clock::time_point m_end;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<TaskId> m_main_queue;
+	u32 m_pending = 0;
+
+	std::atomic<bool> m_failed = false;
+	std::exception_ptr m_exception;
+};
+
+} // namespace vg
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "types.hpp"
+
+namespace vg {
+
+class ThreadPool {
+  public:
+	explicit ThreadPool(u32 thread_count = default_thread_count());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> task);
+
+	// Splits [0, count) into ranges of at least min_chunk and blocks until all are done.
+	// The calling thread takes part, so this is safe to call from inside a task.
+	void parallel_for(usize count, usize min_chunk, const std::function<void(usize, usize)>& fn);
+
+	u32 get_thread_count() const {
+		return static_cast<u32>(m_threads.size());
+	}
+
+  private:
+	static u32 default_thread_count();
+
+	void worker(const std::stop_token& stop);
+	bool run_pending();
+
+	std::vector<std::jthread> m_threads;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable_any m_condition;
+};
+
+} // namespace vg
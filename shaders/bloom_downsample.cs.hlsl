@@ -0,0 +1,52 @@
+#include "post_process.hlsli"
+
+RWTexture2D<float4> source : register(u0);
+RWTexture2D<float4> output : register(u1);
+
+// params: threshold, soft knee, first pass
+
+float3 prefilter(float3 color) {
+	float brightness = max(color.r, max(color.g, color.b));
+	float soft = clamp(brightness - constants.params.x + constants.params.y, 0.0, 2.0 * constants.params.y);
+	soft = soft * soft / (4.0 * constants.params.y + 1e-5);
+
+	float contribution = max(soft, brightness - constants.params.x) / max(brightness, 1e-5);
+	return color * contribution;
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID) {
+	int2 pixel = int2(thread_id.xy);
+	if (any(pixel >= int2(constants.size.xy)))
+		return;
+
+	// 4x4 footprint around the destination texel, averaged as four 2x2 boxes
+	int2 base = pixel * 2;
+	float3 color = 0.0;
+	float total = 0.0;
+
+	[unroll]
+	for (int y = 0; y < 2; y++) {
+		[unroll]
+		for (int x = 0; x < 2; x++) {
+			int2 corner = base + int2(x * 2 - 1, y * 2 - 1);
+			float3 box = (load_clamped(source, corner, constants.source_size).rgb
+						  + load_clamped(source, corner + int2(1, 0), constants.source_size).rgb
+						  + load_clamped(source, corner + int2(0, 1), constants.source_size).rgb
+						  + load_clamped(source, corner + int2(1, 1), constants.source_size).rgb)
+				* 0.25;
+
+			// karis average on the first pass keeps single bright pixels from turning into fireflies
+			float weight = constants.params.z > 0.0 ? 1.0 / (1.0 + luminance(box)) : 1.0;
+			color += box * weight;
+			total += weight;
+		}
+	}
+
+	color /= total;
+
+	if (constants.params.z > 0.0)
+		color = prefilter(color);
+
+	output[pixel] = float4(color, 1.0);
+}
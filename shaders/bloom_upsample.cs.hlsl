@@ -0,0 +1,29 @@
+#include "post_process.hlsli"
+
+RWTexture2D<float4> source : register(u0);
+RWTexture2D<float4> output : register(u1);
+
+// params: filter radius in source texels
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID) {
+	int2 pixel = int2(thread_id.xy);
+	if (any(pixel >= int2(constants.size.xy)))
+		return;
+
+	float2 uv = (float2(pixel) + 0.5) * constants.size.zw;
+	float2 offset = constants.params.x * constants.source_size.zw;
+
+	// 3x3 tent over the lower level, accumulated into this one
+	float3 color = load_bilinear(source, uv, constants.source_size).rgb * 4.0;
+	color += load_bilinear(source, uv + float2(-offset.x, 0.0), constants.source_size).rgb * 2.0;
+	color += load_bilinear(source, uv + float2(offset.x, 0.0), constants.source_size).rgb * 2.0;
+	color += load_bilinear(source, uv + float2(0.0, -offset.y), constants.source_size).rgb * 2.0;
+	color += load_bilinear(source, uv + float2(0.0, offset.y), constants.source_size).rgb * 2.0;
+	color += load_bilinear(source, uv - offset, constants.source_size).rgb;
+	color += load_bilinear(source, uv + offset, constants.source_size).rgb;
+	color += load_bilinear(source, uv + float2(-offset.x, offset.y), constants.source_size).rgb;
+	color += load_bilinear(source, uv + float2(offset.x, -offset.y), constants.source_size).rgb;
+
+	output[pixel] = float4(output[pixel].rgb + color / 16.0, 1.0);
+}
@@ -0,0 +1,136 @@
+#include "lighting.hlsli"
+
+#define GROUP_SIZE 64
+
+ConstantBuffer<ClusterParams> params : register(b0);
+StructuredBuffer<Light> lights : register(t0);
+RWStructuredBuffer<uint> cluster_counts : register(u0);
+RWStructuredBuffer<uint> cluster_lights : register(u1);
+RWStructuredBuffer<uint> overflow : register(u2);
+
+groupshared float4 shared_spheres[GROUP_SIZE]; // view space position, range
+groupshared float4 shared_cones[GROUP_SIZE]; // view space direction, cosine (or 2 for point lights)
+
+float3 view_ray(float2 ndc) {
+	// NOTE: depth is zero to one, so z = 0 lands on the near plane
+	float4 p = mul(params.inv_proj, float4(ndc, 0.0, 1.0));
+	return p.xyz / p.w;
+}
+
+float3 point_at_depth(float3 ray, float depth) {
+	return ray * (depth / -ray.z);
+}
+
+bool sphere_aabb(float3 center, float radius, float3 aabb_min, float3 aabb_max) {
+	float3 closest = clamp(center, aabb_min, aabb_max);
+	float3 delta = closest - center;
+	return dot(delta, delta) <= radius * radius;
+}
+
+// https://bartwronski.com/2017/04/13/cull-that-cone/
+bool sphere_cone(float3 center, float radius, float3 apex, float3 direction, float range, float cos_angle) {
+	float3 v = center - apex;
+	float v_len_sq = dot(v, v);
+	float v1_len = dot(v, direction);
+	float sin_angle = sqrt(saturate(1.0 - cos_angle * cos_angle));
+	float distance_closest = cos_angle * sqrt(max(v_len_sq - v1_len * v1_len, 0.0)) - v1_len * sin_angle;
+
+	bool angle_cull = distance_closest > radius;
+	bool front_cull = v1_len > radius + range;
+	bool back_cull = v1_len < -radius;
+
+	return !(angle_cull || front_cull || back_cull);
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID, uint group_index : SV_GroupIndex) {
+	uint cluster_count = params.grid.x * params.grid.y * params.grid.z;
+	uint index = thread_id.x;
+	bool valid = index < cluster_count;
+
+	uint3 cluster;
+	cluster.x = index % params.grid.x;
+	cluster.y = (index / params.grid.x) % params.grid.y;
+	cluster.z = index / (params.grid.x * params.grid.y);
+
+	// screen tile in ndc, y points up
+	float2 tile_size = 2.0 / float2(params.grid.xy);
+	float2 ndc_min = float2(-1.0 + cluster.x * tile_size.x, 1.0 - (cluster.y + 1) * tile_size.y);
+	float2 ndc_max = ndc_min + tile_size;
+
+	// exponential depth slices
+	float near_plane = params.depth.x;
+	float far_plane = params.depth.y;
+	float slice_near = near_plane * pow(far_plane / near_plane, float(cluster.z) / params.grid.z);
+	float slice_far = near_plane * pow(far_plane / near_plane, float(cluster.z + 1) / params.grid.z);
+
+	float3 rays[4] = {
+		view_ray(ndc_min),
+		view_ray(float2(ndc_max.x, ndc_min.y)),
+		view_ray(float2(ndc_min.x, ndc_max.y)),
+		view_ray(ndc_max),
+	};
+
+	float3 aabb_min = 1e30;
+	float3 aabb_max = -1e30;
+
+	[unroll]
+	for (uint i = 0; i < 4; i++) {
+		float3 p0 = point_at_depth(rays[i], slice_near);
+		float3 p1 = point_at_depth(rays[i], slice_far);
+		aabb_min = min(aabb_min, min(p0, p1));
+		aabb_max = max(aabb_max, max(p0, p1));
+	}
+
+	float3 cluster_center = (aabb_min + aabb_max) * 0.5;
+	float cluster_radius = length(aabb_max - cluster_center);
+
+	uint light_count = params.grid.w;
+	uint count = 0;
+	uint dropped = 0;
+	uint base = index * MAX_LIGHTS_PER_CLUSTER;
+
+	for (uint batch = 0; batch < light_count; batch += GROUP_SIZE) {
+		// transform one batch of lights to view space, shared by the whole group
+		uint light_index = batch + group_index;
+		if (light_index < light_count) {
+			Light light = lights[light_index];
+			float3 position = mul(params.view, float4(light.position, 1.0)).xyz;
+			float3 direction = normalize(mul((float3x3)params.view, light.direction));
+
+			shared_spheres[group_index] = float4(position, light.range);
+			shared_cones[group_index] = float4(direction, light.type == LIGHT_TYPE_SPOT ? light.spot_outer : 2.0);
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+
+		uint batch_count = min(GROUP_SIZE, light_count - batch);
+		for (uint j = 0; j < batch_count && valid; j++) {
+			float4 sphere = shared_spheres[j];
+			float4 cone = shared_cones[j];
+
+			if (!sphere_aabb(sphere.xyz, sphere.w, aabb_min, aabb_max))
+				continue;
+			if (cone.w <= 1.0 && !sphere_cone(cluster_center, cluster_radius, sphere.xyz, cone.xyz, sphere.w, cone.w))
+				continue;
+
+			if (count < MAX_LIGHTS_PER_CLUSTER) {
+				cluster_lights[base + count] = batch + j;
+				count++;
+			} else {
+				dropped++;
+			}
+		}
+
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	if (valid)
+		cluster_counts[index] = count;
+
+	// full clusters still shade, just without the lights past the limit, the cpu reads these back to report it
+	if (valid && dropped > 0) {
+		InterlockedAdd(overflow[OVERFLOW_CLUSTERS], 1);
+		InterlockedAdd(overflow[OVERFLOW_LIGHTS], dropped);
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef LIGHTING_HLSLI
+#define LIGHTING_HLSLI
+
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+// NOTE: must match gfx::LightOverflow
+#define OVERFLOW_CLUSTERS 0
+#define OVERFLOW_LIGHTS 1
+
+// NOTE: must match gfx::Light
+struct Light {
+	float3 position;
+	float range;
+	float3 color;
+	float intensity;
+	float3 direction;
+	float spot_outer;
+	float spot_inner;
+	uint type;
+	float2 padding;
+};
+
+// NOTE: must match gfx::ClusterParams
+struct ClusterParams {
+	float4x4 view;
+	float4x4 inv_proj;
+	float4 camera_position;
+	uint4 grid; // cluster counts, light count
+	float4 screen; // size, inverse size
+	float4 depth; // near, far, slice scale, slice bias
+};
+
+uint cluster_index(uint3 cluster, uint4 grid) {
+	return cluster.x + cluster.y * grid.x + cluster.z * grid.x * grid.y;
+}
+
+uint3 cluster_from_pixel(float2 pixel, float view_depth, ClusterParams params) {
+	uint3 cluster;
+	cluster.xy = uint2(pixel * params.screen.zw * float2(params.grid.xy));
+	cluster.z = uint(max(log(view_depth) * params.depth.z + params.depth.w, 0.0));
+	return min(cluster, params.grid.xyz - 1);
+}
+
+float light_attenuation(float distance, float range) {
+	float ratio = distance / range;
+	float window = saturate(1.0 - ratio * ratio * ratio * ratio);
+	return window * window / (distance * distance + 1.0);
+}
+
+float spot_attenuation(Light light, float3 to_light) {
+	if (light.type != LIGHT_TYPE_SPOT)
+		return 1.0;
+
+	float cos_angle = dot(-to_light, light.direction);
+	return smoothstep(light.spot_outer, light.spot_inner, cos_angle);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "lighting.hlsli"
+#include "lit.hlsli"
+
+struct Attributes {
+	float3 position : POSITION;
+	float3 normal : NORMAL;
+	float2 uv : TEXCOORD;
+};
+
+Varyings VSmain(Attributes input) {
+	return transform_vertex(input.position, input.normal, input.uv);
+}
+
+Texture2D t_texture : register(t0);
+SamplerState s_sampler : register(s0);
+
+ConstantBuffer<ClusterParams> cluster_params : register(b0, space1);
+StructuredBuffer<Light> lights : register(t0, space1);
+StructuredBuffer<uint> cluster_counts : register(t1, space1);
+StructuredBuffer<uint> cluster_lights : register(t2, space1);
+
+static const float3 AMBIENT = float3(0.03, 0.03, 0.03);
+static const float SHININESS = 32.0;
+
+float4 PSmain(Varyings input) : SV_TARGET {
+	float4 albedo = t_texture.Sample(s_sampler, input.uv) * tint;
+
+	float3 normal = normalize(input.normal);
+	float3 to_camera = normalize(cluster_params.camera_position.xyz - input.world_position);
+
+	uint3 cluster = cluster_from_pixel(input.position.xy, input.view_depth, cluster_params);
+	uint index = cluster_index(cluster, cluster_params.grid);
+	uint count = cluster_counts[index];
+	uint base = index * MAX_LIGHTS_PER_CLUSTER;
+
+	float3 color = AMBIENT * albedo.rgb;
+
+	for (uint i = 0; i < count; i++) {
+		Light light = lights[cluster_lights[base + i]];
+
+		float3 delta = light.position - input.world_position;
+		float distance = length(delta);
+		if (distance >= light.range)
+			continue;
+
+		float3 to_light = delta / distance;
+		float attenuation = light_attenuation(distance, light.range) * spot_attenuation(light, to_light);
+		float3 radiance = light.color * light.intensity * attenuation;
+
+		float n_dot_l = saturate(dot(normal, to_light));
+		float3 half_vector = normalize(to_light + to_camera);
+		float specular = pow(saturate(dot(normal, half_vector)), SHININESS) * n_dot_l;
+
+		color += (albedo.rgb * n_dot_l + specular) * radiance;
+	}
+
+	return float4(color, albedo.a);
+}
@@ -0,0 +1,38 @@
+#ifndef LIT_HLSLI
+#define LIT_HLSLI
+
+cbuffer PushConstants : register(b0) {
+	float4x4 model;
+	float4 tint;
+}
+
+cbuffer UniformBuffer : register(b1) {
+	float4x4 view;
+	float4x4 proj;
+}
+
+struct Varyings {
+	float4 position : SV_POSITION;
+	float3 world_position : POSITION;
+	float3 normal : NORMAL;
+	float2 uv : TEXCOORD;
+	float view_depth : DEPTH;
+};
+
+// shared by the vertex and mesh shader paths
+Varyings transform_vertex(float3 position, float3 normal, float2 uv) {
+	Varyings output;
+
+	float4 world = mul(model, float4(position, 1.0));
+	float4 eye = mul(view, world);
+
+	output.position = mul(proj, eye);
+	output.world_position = world.xyz;
+	output.normal = mul((float3x3)model, normal);
+	output.uv = uv;
+	output.view_depth = -eye.z;
+
+	return output;
+}
+
+#endif
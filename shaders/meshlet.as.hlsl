@@ -0,0 +1,43 @@
+#include "lit.hlsli"
+#include "meshlet.hlsli"
+
+ConstantBuffer<MeshletCullParams> params : register(b0, space2);
+StructuredBuffer<Meshlet> meshlets : register(t0, space2);
+RWStructuredBuffer<uint> counters : register(u0, space2);
+
+groupshared MeshletPayload payload;
+groupshared uint shared_count;
+groupshared uint shared_triangles;
+
+// culls TASK_GROUP_SIZE meshlets of the instance in the push constants and launches a mesh group per survivor
+[numthreads(TASK_GROUP_SIZE, 1, 1)]
+void ASmain(uint3 thread_id : SV_DispatchThreadID, uint group_index : SV_GroupIndex) {
+	if (group_index == 0) {
+		shared_count = 0;
+		shared_triangles = 0;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	uint index = thread_id.x;
+
+	if (index < params.counts.x) {
+		Meshlet meshlet = meshlets[index];
+
+		if (meshlet_visible(meshlet, model, params)) {
+			uint slot;
+			InterlockedAdd(shared_count, 1, slot);
+			InterlockedAdd(shared_triangles, meshlet.ranges.w);
+			payload.meshlets[slot] = index;
+		}
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (group_index == 0 && shared_count > 0) {
+		InterlockedAdd(counters[COUNTER_VISIBLE_MESHLETS], shared_count);
+		InterlockedAdd(counters[COUNTER_VISIBLE_TRIANGLES], shared_triangles);
+	}
+
+	DispatchMesh(shared_count, 1, 1, payload);
+}
@@ -0,0 +1,65 @@
+#ifndef MESHLET_HLSLI
+#define MESHLET_HLSLI
+
+#define CULL_GROUP_SIZE 64
+#define TASK_GROUP_SIZE 32
+
+#define MAX_MESHLET_VERTICES 64
+#define MAX_MESHLET_TRIANGLES 124
+
+// NOTE: must match gfx::GpuMeshlet
+struct Meshlet {
+	float4 sphere; // center, radius
+	float4 cone_apex; // w unused
+	float4 cone_axis; // axis, cutoff
+	uint4 ranges; // vertex offset, triangle offset, vertex count, triangle count
+};
+
+// NOTE: must match gfx::MeshletCullParams
+struct MeshletCullParams {
+	float4 planes[6];
+	float4 camera_position;
+	uint4 counts; // meshlets, instances
+};
+
+// NOTE: must match gfx::MeshletCounter
+#define COUNTER_VISIBLE_MESHLETS 0
+#define COUNTER_VISIBLE_TRIANGLES 1
+
+struct MeshletPayload {
+	uint meshlets[TASK_GROUP_SIZE];
+};
+
+bool meshlet_visible(Meshlet meshlet, float4x4 model, MeshletCullParams params) {
+	float3 center = mul(model, float4(meshlet.sphere.xyz, 1.0)).xyz;
+	// NOTE: model[i] is a row, the axis scales are the lengths of the columns
+	float3x3 basis = (float3x3)model;
+	float3 scales = float3(
+		length(mul(basis, float3(1.0, 0.0, 0.0))),
+		length(mul(basis, float3(0.0, 1.0, 0.0))),
+		length(mul(basis, float3(0.0, 0.0, 1.0)))
+	);
+	float scale = max(scales.x, max(scales.y, scales.z));
+	float radius = meshlet.sphere.w * scale;
+
+	[unroll]
+	for (uint i = 0; i < 6; i++) {
+		if (dot(params.planes[i].xyz, center) + params.planes[i].w < -radius)
+			return false;
+	}
+
+	// every triangle faces away when the camera is inside the negative cone
+	// NOTE: assumes uniform scale, non-uniform scale would have to widen the cone
+	float cutoff = meshlet.cone_axis.w;
+	if (cutoff < 1.0) {
+		float3 apex = mul(model, float4(meshlet.cone_apex.xyz, 1.0)).xyz;
+		float3 axis = normalize(mul((float3x3)model, meshlet.cone_axis.xyz));
+
+		if (dot(normalize(apex - params.camera_position.xyz), axis) >= cutoff)
+			return false;
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "lit.hlsli"
+#include "meshlet.hlsli"
+
+// NOTE: must match vg::Vertex
+struct MeshVertex {
+	float3 position;
+	float3 normal;
+	float2 uv;
+};
+
+StructuredBuffer<Meshlet> meshlets : register(t0, space2);
+StructuredBuffer<uint> meshlet_vertices : register(t1, space2);
+StructuredBuffer<uint> meshlet_triangles : register(t2, space2);
+StructuredBuffer<MeshVertex> vertex_buffer : register(t3, space2);
+
+#define MESH_GROUP_SIZE 128
+
+[outputtopology("triangle")]
+[numthreads(MESH_GROUP_SIZE, 1, 1)]
+void MSmain(
+	uint group_index : SV_GroupIndex,
+	uint group_id : SV_GroupID,
+	in payload MeshletPayload payload,
+	out vertices Varyings out_vertices[MAX_MESHLET_VERTICES],
+	out indices uint3 out_triangles[MAX_MESHLET_TRIANGLES]
+) {
+	Meshlet meshlet = meshlets[payload.meshlets[group_id]];
+	uint vertex_count = meshlet.ranges.z;
+	uint triangle_count = meshlet.ranges.w;
+
+	SetMeshOutputCounts(vertex_count, triangle_count);
+
+	if (group_index < vertex_count) {
+		MeshVertex vertex = vertex_buffer[meshlet_vertices[meshlet.ranges.x + group_index]];
+		out_vertices[group_index] = transform_vertex(vertex.position, vertex.normal, vertex.uv);
+	}
+
+	if (group_index < triangle_count) {
+		uint packed = meshlet_triangles[meshlet.ranges.y + group_index];
+		out_triangles[group_index] = uint3(packed & 0xff, (packed >> 8) & 0xff, (packed >> 16) & 0xff);
+	}
+}
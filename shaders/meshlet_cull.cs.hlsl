@@ -0,0 +1,61 @@
+#include "meshlet.hlsli"
+
+// NOTE: must match nvrhi::DrawIndexedIndirectArguments
+struct DrawArguments {
+	uint index_count;
+	uint instance_count;
+	uint start_index;
+	int base_vertex;
+	uint start_instance;
+};
+
+ConstantBuffer<MeshletCullParams> params : register(b0);
+StructuredBuffer<Meshlet> meshlets : register(t0);
+StructuredBuffer<float4x4> instances : register(t1);
+RWStructuredBuffer<DrawArguments> draw_arguments : register(u0);
+RWStructuredBuffer<uint> counters : register(u1);
+
+groupshared uint shared_meshlets;
+groupshared uint shared_triangles;
+
+// one thread per meshlet and instance, culled meshlets keep their slot with an instance count of zero
+[numthreads(CULL_GROUP_SIZE, 1, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID, uint group_index : SV_GroupIndex) {
+	if (group_index == 0) {
+		shared_meshlets = 0;
+		shared_triangles = 0;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	uint meshlet_count = params.counts.x;
+	uint index = thread_id.x;
+	uint instance = thread_id.y;
+
+	if (index < meshlet_count) {
+		Meshlet meshlet = meshlets[index];
+		bool visible = meshlet_visible(meshlet, instances[instance], params);
+
+		DrawArguments args;
+		args.index_count = meshlet.ranges.w * 3;
+		args.instance_count = visible ? 1 : 0;
+		args.start_index = meshlet.ranges.y * 3;
+		args.base_vertex = 0;
+		args.start_instance = 0;
+
+		draw_arguments[instance * meshlet_count + index] = args;
+
+		if (visible) {
+			InterlockedAdd(shared_meshlets, 1);
+			InterlockedAdd(shared_triangles, meshlet.ranges.w);
+		}
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	// one global atomic per group instead of per meshlet
+	if (group_index == 0 && shared_meshlets > 0) {
+		InterlockedAdd(counters[COUNTER_VISIBLE_MESHLETS], shared_meshlets);
+		InterlockedAdd(counters[COUNTER_VISIBLE_TRIANGLES], shared_triangles);
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef POST_PROCESS_HLSLI
+#define POST_PROCESS_HLSLI
+
+#define GROUP_SIZE 8
+
+// NOTE: must match gfx::PostConstants
+struct PostConstants {
+	float4x4 reprojection; // current ndc to previous clip space
+	float4 size; // destination size, inverse size
+	float4 source_size; // source size, inverse size
+	float4 params; // pass specific
+};
+
+ConstantBuffer<PostConstants> constants : register(b0);
+
+float luminance(float3 color) {
+	return dot(color, float3(0.2126, 0.7152, 0.0722));
+}
+
+float3 rgb_to_ycocg(float3 color) {
+	return float3(
+		dot(color, float3(0.25, 0.5, 0.25)),
+		dot(color, float3(0.5, 0.0, -0.5)),
+		dot(color, float3(-0.25, 0.5, -0.25))
+	);
+}
+
+float3 ycocg_to_rgb(float3 color) {
+	return float3(color.x + color.y - color.z, color.x + color.z, color.x - color.y - color.z);
+}
+
+float3 linear_to_srgb(float3 color) {
+	float3 low = color * 12.92;
+	float3 high = 1.055 * pow(color, 1.0 / 2.4) - 0.055;
+	return select(color <= 0.0031308, low, high);
+}
+
+// NOTE: intermediate targets stay in the unordered access state on the compute queue,
+// so they are read with loads and filtered by hand instead of sampled
+float4 load_clamped(RWTexture2D<float4> texture, int2 pixel, float4 size) {
+	return texture[clamp(pixel, int2(0, 0), int2(size.xy) - 1)];
+}
+
+float4 load_bilinear(RWTexture2D<float4> texture, float2 uv, float4 size) {
+	float2 position = uv * size.xy - 0.5;
+	int2 pixel = int2(floor(position));
+	float2 weight = position - floor(position);
+
+	float4 a = load_clamped(texture, pixel, size);
+	float4 b = load_clamped(texture, pixel + int2(1, 0), size);
+	float4 c = load_clamped(texture, pixel + int2(0, 1), size);
+	float4 d = load_clamped(texture, pixel + int2(1, 1), size);
+
+	return lerp(lerp(a, b, weight.x), lerp(c, d, weight.x), weight.y);
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "post_process.hlsli"
+
+Texture2D<float4> scene_color : register(t0);
+Texture2D<float> scene_depth : register(t1);
+RWTexture2D<float4> history : register(u0);
+RWTexture2D<float4> output : register(u1);
+
+// params: current frame weight, history valid
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID) {
+	int2 pixel = int2(thread_id.xy);
+	if (any(pixel >= int2(constants.size.xy)))
+		return;
+
+	int2 max_pixel = int2(constants.size.xy) - 1;
+	float3 current = scene_color[pixel].rgb;
+
+	// neighbourhood bounds in ycocg, history outside them is rejected as stale
+	float3 neighbourhood_min = 1e30;
+	float3 neighbourhood_max = -1e30;
+
+	[unroll]
+	for (int y = -1; y <= 1; y++) {
+		[unroll]
+		for (int x = -1; x <= 1; x++) {
+			float3 color = rgb_to_ycocg(scene_color[clamp(pixel + int2(x, y), int2(0, 0), max_pixel)].rgb);
+			neighbourhood_min = min(neighbourhood_min, color);
+			neighbourhood_max = max(neighbourhood_max, color);
+		}
+	}
+
+	// camera-only reprojection from depth, there are no per-object motion vectors
+	float2 uv = (float2(pixel) + 0.5) * constants.size.zw;
+	float4 ndc = float4(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, scene_depth[pixel], 1.0);
+	float4 previous = mul(constants.reprojection, ndc);
+	previous.xy /= previous.w;
+
+	float2 history_uv = float2(previous.x * 0.5 + 0.5, 0.5 - previous.y * 0.5);
+	bool valid = constants.params.y > 0.0 && all(history_uv >= 0.0) && all(history_uv <= 1.0);
+
+	float3 result = current;
+
+	if (valid) {
+		float3 previous_color = load_bilinear(history, history_uv, constants.size).rgb;
+		previous_color = ycocg_to_rgb(clamp(rgb_to_ycocg(previous_color), neighbourhood_min, neighbourhood_max));
+
+		// weight by inverse luminance so bright pixels don't dominate the blend and flicker
+		float current_weight = constants.params.x / (1.0 + luminance(current));
+		float history_weight = (1.0 - constants.params.x) / (1.0 + luminance(previous_color));
+		result = (current * current_weight + previous_color * history_weight) / (current_weight + history_weight);
+	}
+
+	output[pixel] = float4(result, 1.0);
+}
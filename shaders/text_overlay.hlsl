@@ -0,0 +1,56 @@
+cbuffer PushConstants : register(b0) {
+	float2 inverse_screen_size;
+}
+
+// NOTE: must match the GpuGlyph struct in include/gfx/text_overlay.hpp
+struct Glyph {
+	float4 rect; // x, y, width, height in pixels
+	uint bits; // 3x5 cells, bit = row * 3 + column, row 0 at the top
+	uint color; // rgba8, r in the low byte
+	uint2 padding;
+};
+
+StructuredBuffer<Glyph> glyphs : register(t0);
+
+static const uint GLYPH_COLUMNS = 3;
+static const uint GLYPH_ROWS = 5;
+
+struct Varyings {
+	float4 position : SV_POSITION;
+	float2 cell : TEXCOORD;
+	nointerpolation uint bits : BITS;
+	nointerpolation float4 color : COLOR;
+};
+
+// six vertices per glyph, no vertex or index buffer
+Varyings VSmain(uint vertex_id : SV_VertexID) {
+	static const float2 CORNERS[6] = {
+		float2(0, 0), float2(1, 0), float2(0, 1),
+		float2(0, 1), float2(1, 0), float2(1, 1),
+	};
+
+	Glyph glyph = glyphs[vertex_id / 6];
+	float2 corner = CORNERS[vertex_id % 6];
+	float2 pixel = glyph.rect.xy + corner * glyph.rect.zw;
+
+	Varyings output;
+	output.position = float4(pixel * inverse_screen_size * float2(2, -2) + float2(-1, 1), 0, 1);
+	output.cell = corner * float2(GLYPH_COLUMNS, GLYPH_ROWS);
+	output.bits = glyph.bits;
+	output.color = float4(
+		glyph.color & 0xff,
+		(glyph.color >> 8) & 0xff,
+		(glyph.color >> 16) & 0xff,
+		glyph.color >> 24
+	) / 255.0;
+
+	return output;
+}
+
+float4 PSmain(Varyings input) : SV_TARGET {
+	uint2 cell = min(uint2(input.cell), uint2(GLYPH_COLUMNS - 1, GLYPH_ROWS - 1));
+	if ((input.bits & (1u << (cell.y * GLYPH_COLUMNS + cell.x))) == 0)
+		discard;
+
+	return input.color;
+}
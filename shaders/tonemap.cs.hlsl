@@ -0,0 +1,29 @@
+#include "post_process.hlsli"
+
+RWTexture2D<float4> scene_color : register(u0);
+RWTexture2D<float4> bloom : register(u1);
+RWTexture2D<unorm float4> output : register(u2);
+
+// params: exposure, bloom intensity
+
+// https://knarkowicz.wordpress.com/2016/01/06/aces-filmic-tone-mapping-curve/
+float3 aces(float3 color) {
+	return saturate((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14));
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void CSmain(uint3 thread_id : SV_DispatchThreadID) {
+	int2 pixel = int2(thread_id.xy);
+	if (any(pixel >= int2(constants.size.xy)))
+		return;
+
+	float3 color = scene_color[pixel].rgb;
+
+	if (constants.params.y > 0.0) {
+		float2 uv = (float2(pixel) + 0.5) * constants.size.zw;
+		color += load_bilinear(bloom, uv, constants.source_size).rgb * constants.params.y;
+	}
+
+	// NOTE: the output is copied into the swapchain, srgb formats can't be written as uavs so encode here
+	output[pixel] = float4(linear_to_srgb(aces(color * constants.params.x)), 1.0);
+}
@@ -1,17 +1,28 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_FORCE_RIGHT_HANDED
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/mat4x4.hpp>
+#include <glm/matrix.hpp>
 
 #include <nvrhi/utils.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <optional>
 #include <print>
 #include <ranges>
 #include <stdexcept>
 
 #include "app.hpp"
+#include "task_graph.hpp"
 
 namespace vg {
 
@@ -40,165 +51,597 @@ struct UniformBuffer {
 	glm::mat4 projection;
 };
 
-App::App(std::span<const std::string_view> args) {
+static constexpr f32 NEAR_PLANE = 0.1f;
+static constexpr f32 FAR_PLANE = 1000.f;
+
+static constexpr u32 LIGHT_GRID = 16;
+
+static constexpr f32 TORUS_RADIUS = 1.f;
+static constexpr f32 TORUS_TUBE_RADIUS = 0.3f;
+static constexpr u32 TORUS_SEGMENTS = 384; // around the ring
+static constexpr u32 TORUS_SIDES = 96; // around the tube
+static constexpr u32 TORUS_GRID = 8;
+
+static constexpr u32 TEXTURE_SIZE = 256;
+static constexpr u32 TEXTURE_MIPS = 9; // down to 1x1
+static constexpr u32 EVICTED_MIP = 3; // first mip still resident once the texture is evicted
+
+static constexpr auto OVERLAY_REFRESH = std::chrono::milliseconds(500);
+static constexpr f64 FRAME_BUDGET_MS = 1000.0 / 60.0;
+static constexpr f64 MEGABYTE = 1024.0 * 1024.0;
+
+static const scene::AABB QUAD_BOUNDS = {{-1.f, -1.f, 0.f}, {1.f, 1.f, 0.f}};
+static const scene::AABB TORUS_BOUNDS = {
+	{-TORUS_RADIUS - TORUS_TUBE_RADIUS, -TORUS_TUBE_RADIUS, -TORUS_RADIUS - TORUS_TUBE_RADIUS},
+	{TORUS_RADIUS + TORUS_TUBE_RADIUS, TORUS_TUBE_RADIUS, TORUS_RADIUS + TORUS_TUBE_RADIUS},
+};
+
+static const scene::AABB& get_bounds(const MeshId mesh) {
+	return mesh == MeshId::Torus ? TORUS_BOUNDS : QUAD_BOUNDS;
+}
+
+enum class ShaderId : u32 {
+	LitVertex,
+	LitPixel,
+	LightBinning,
+	Taa,
+	BloomDownsample,
+	BloomUpsample,
+	Tonemap,
+	MeshletCull,
+	MeshletAmplification,
+	MeshletMesh,
+	OverlayVertex,
+	OverlayPixel,
+};
+
+struct ShaderFile {
+	std::string_view path;
+	nvrhi::ShaderType type;
+};
+
+// NOTE: indexed by ShaderId
+static constexpr std::array SHADER_FILES = {
+	ShaderFile {"shaders/lit.vs.dxil", nvrhi::ShaderType::Vertex},
+	ShaderFile {"shaders/lit.ps.dxil", nvrhi::ShaderType::Pixel},
+	ShaderFile {"shaders/light_binning.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/taa.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/bloom_downsample.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/bloom_upsample.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/tonemap.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/meshlet_cull.cs.dxil", nvrhi::ShaderType::Compute},
+	ShaderFile {"shaders/meshlet.as.dxil", nvrhi::ShaderType::Amplification},
+	ShaderFile {"shaders/meshlet.ms.dxil", nvrhi::ShaderType::Mesh},
+	ShaderFile {"shaders/text_overlay.vs.dxil", nvrhi::ShaderType::Vertex},
+	ShaderFile {"shaders/text_overlay.ps.dxil", nvrhi::ShaderType::Pixel},
+};
+
+static constexpr std::string_view METRICS_FILE_ARG = "--metrics-file=";
+static constexpr std::string_view METRICS_UDP_ARG = "--metrics-udp=";
+
+static glm::vec3 hue_to_rgb(const f32 hue) {
+	const glm::vec3 offset = glm::vec3(0.f, 2.f, 1.f) / 3.f;
+	return glm::clamp(glm::abs(glm::fract(glm::vec3(hue) + offset) * 6.f - 3.f) - 1.f, 0.f, 1.f);
+}
+
+// four colored quadrants, every mip is box filtered from the one above
+static std::vector<std::vector<glm::u8vec4>> build_texture_mips() {
+	static constexpr std::array<glm::u8vec4, 4> COLORS = {
+		glm::u8vec4(255, 0, 0, 255),
+		glm::u8vec4(0, 255, 0, 255),
+		glm::u8vec4(0, 0, 255, 255),
+		glm::u8vec4(255, 255, 0, 255),
+	};
+
+	std::vector<std::vector<glm::u8vec4>> mips(TEXTURE_MIPS);
+	mips[0].resize(TEXTURE_SIZE * TEXTURE_SIZE);
+
+	for (u32 y = 0; y < TEXTURE_SIZE; y++) {
+		for (u32 x = 0; x < TEXTURE_SIZE; x++) {
+			mips[0][y * TEXTURE_SIZE + x] = COLORS[(y >= TEXTURE_SIZE / 2) * 2 + (x >= TEXTURE_SIZE / 2)];
+		}
+	}
+
+	for (u32 mip = 1; mip < TEXTURE_MIPS; mip++) {
+		const u32 size = TEXTURE_SIZE >> mip;
+		const auto& above = mips[mip - 1];
+		mips[mip].resize(size * size);
+
+		for (u32 y = 0; y < size; y++) {
+			for (u32 x = 0; x < size; x++) {
+				glm::uvec4 sum = glm::uvec4(0);
+				for (u32 i = 0; i < 4; i++) {
+					sum += glm::uvec4(above[(2 * y + i / 2) * size * 2 + 2 * x + i % 2]);
+				}
+
+				mips[mip][y * size + x] = glm::u8vec4(sum / 4u);
+			}
+		}
+	}
+
+	return mips;
+}
+
+// writes mips[i] into mip i of the texture, returns the bytes uploaded
+static u64 write_texture_mips(
+	nvrhi::ICommandList* command_list,
+	nvrhi::ITexture* texture,
+	std::span<const std::vector<glm::u8vec4>> mips
+) {
+	const u32 width = texture->getDesc().width;
+	u64 bytes = 0;
+
+	for (u32 mip = 0; mip < mips.size(); mip++) {
+		const usize row_pitch = std::max(width >> mip, 1u) * sizeof(glm::u8vec4);
+		command_list->writeTexture(texture, 0, mip, mips[mip].data(), row_pitch);
+		bytes += mips[mip].size() * sizeof(glm::u8vec4);
+	}
+
+	return bytes;
+}
+
+// stand-in for a dense cad part, lies in the xz plane around the y axis
+static void build_torus(std::vector<Vertex>& vertices, std::vector<u32>& indices) {
+	for (u32 i = 0; i < TORUS_SEGMENTS; i++) {
+		for (u32 j = 0; j < TORUS_SIDES; j++) {
+			const f32 u = static_cast<f32>(i) / TORUS_SEGMENTS;
+			const f32 v = static_cast<f32>(j) / TORUS_SIDES;
+			const f32 theta = u * glm::two_pi<f32>();
+			const f32 phi = v * glm::two_pi<f32>();
+
+			const glm::vec3 normal = {std::cos(phi) * std::cos(theta), std::sin(phi), std::cos(phi) * std::sin(theta)};
+			const glm::vec3 ring = {std::cos(theta) * TORUS_RADIUS, 0.f, std::sin(theta) * TORUS_RADIUS};
+
+			vertices.push_back({ring + normal * TORUS_TUBE_RADIUS, normal, {u * 8.f, v * 2.f}});
+		}
+	}
+
+	const auto index = [](const u32 i, const u32 j) { return (i % TORUS_SEGMENTS) * TORUS_SIDES + j % TORUS_SIDES; };
+
+	// NOTE: wound counter-clockwise seen from outside, like the quad
+	for (u32 i = 0; i < TORUS_SEGMENTS; i++) {
+		for (u32 j = 0; j < TORUS_SIDES; j++) {
+			indices.insert(indices.end(), {index(i, j), index(i, j + 1), index(i + 1, j + 1)});
+			indices.insert(indices.end(), {index(i, j), index(i + 1, j + 1), index(i + 1, j)});
+		}
+	}
+}
+
+App::App(std::span<const std::string_view> args) : m_start_time(std::chrono::steady_clock::now()) {
+	gfx::DeviceOptions device_options = {};
+	MetricsExportOptions export_options = {};
+	bool mesh_shaders = true;
+
 	for (auto [idx, arg] : std::views::enumerate(args)) {
 		std::println("arg[{}] = {}", idx, arg);
+
+		if (arg == "--gpu-validation")
+			device_options.gpu_validation = true;
+		if (arg == "--no-mesh-shaders")
+			mesh_shaders = false;
+		if (arg.starts_with(METRICS_FILE_ARG))
+			export_options.file = arg.substr(METRICS_FILE_ARG.size());
+		if (arg.starts_with(METRICS_UDP_ARG))
+			export_options.udp = arg.substr(METRICS_UDP_ARG.size());
 	}
 
-	if (!SDL_Init(SDL_INIT_VIDEO))
-		throw std::runtime_error("Failed to initialize SDL");
+	std::println("current_path: {}", std::filesystem::current_path().string());
 
-	m_window = SDL_CreateWindow("Vanguard", 1600, 900, SDL_WINDOW_RESIZABLE);
-	if (m_window == nullptr)
-		throw std::runtime_error("Failed to create window");
+	std::array<std::vector<std::byte>, SHADER_FILES.size()> shader_code;
+	std::array<nvrhi::ShaderHandle, SHADER_FILES.size()> shaders;
 
-	std::println("current_path: {}", std::filesystem::current_path().string());
+	const auto shader = [&](const ShaderId id) {
+		return shaders[static_cast<usize>(id)];
+	};
+
+	nvrhi::BindingLayoutHandle binding_layout;
+
+	// startup runs as a task graph so file io, the cpu side scene and pipeline creation overlap with
+	// device and swapchain creation, instead of adding up
+	TaskGraph graph(m_thread_pool);
 
-	auto vertex_shader_code = load_shader("shaders/basic.vs.dxil");
-	auto fragment_shader_code = load_shader("shaders/basic.ps.dxil");
+	// NOTE: sdl video and the dxgi swapchain use the window's message queue, so they stay on the main thread
+	const auto window = graph.add_main("window", [&] {
+		if (!SDL_Init(SDL_INIT_VIDEO))
+			throw std::runtime_error("Failed to initialize SDL");
 
-	m_device = gfx::IDevice::create();
-	m_device->create_swapchain(m_window);
-	m_device->resize_swapchain();
+		m_sdl.initialized = true;
+
+		m_sdl.window = SDL_CreateWindow("Vanguard", 1600, 900, SDL_WINDOW_RESIZABLE);
+		if (m_sdl.window == nullptr)
+			throw std::runtime_error("Failed to create window");
+	});
+
+	const auto device = graph.add("device", [&] { m_device = gfx::IDevice::create(device_options); });
+
+	const auto read_shaders = graph.add("read_shaders", [&] {
+		for (auto [idx, file] : std::views::enumerate(SHADER_FILES)) {
+			shader_code[idx] = load_shader(file.path);
+		}
+	});
+
+	const auto scene = graph.add("scene", [&] {
+		m_vertices.push_back({{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}});
+		m_vertices.push_back({{-1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}});
+		m_vertices.push_back({{1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f}});
+		m_vertices.push_back({{1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}});
+
+		m_indices.push_back(0);
+		m_indices.push_back(1);
+		m_indices.push_back(2);
+		m_indices.push_back(2);
+		m_indices.push_back(3);
+		m_indices.push_back(0);
+
+		m_texture_mips = build_texture_mips();
+
+		glm::mat4 floor = glm::translate(glm::mat4(1.f), glm::vec3(0, -1.5, 0));
+		floor = glm::rotate(floor, glm::radians(-90.f), glm::vec3(1, 0, 0));
+		floor = glm::scale(floor, glm::vec3(20.f));
+
+		m_objects.push_back({glm::mat4(1.f), glm::vec4(1.f)});
+		m_objects.push_back({floor, glm::vec4(.1f, .1f, .1f, 1.f)});
+
+		for (u32 x = 0; x < TORUS_GRID; x++) {
+			for (u32 z = 0; z < TORUS_GRID; z++) {
+				const f32 hue = static_cast<f32>(x * TORUS_GRID + z) / (TORUS_GRID * TORUS_GRID);
+				const glm::vec3 position = {(x - TORUS_GRID / 2.f) * 3.f + 1.5f, -0.2f, -3.f * (z + 1.f)};
+
+				glm::mat4 model = glm::translate(glm::mat4(1.f), position);
+				model = glm::rotate(model, hue * glm::pi<f32>(), glm::vec3(1, 0, 0));
+
+				m_objects.push_back({model, glm::vec4(hue_to_rgb(hue), 1.f), MeshId::Torus});
+			}
+		}
+
+		for (auto [idx, object] : std::views::enumerate(m_objects)) {
+			object.proxy = m_bvh.insert(get_bounds(object.mesh).transform(object.model), static_cast<u32>(idx));
+		}
+
+		for (u32 x = 0; x < LIGHT_GRID; x++) {
+			for (u32 z = 0; z < LIGHT_GRID; z++) {
+				const f32 hue = static_cast<f32>(x * LIGHT_GRID + z) / (LIGHT_GRID * LIGHT_GRID);
+
+				gfx::Light light = {};
+				light.position = glm::vec3(x, 0, z) - glm::vec3(LIGHT_GRID / 2.f, 1.2f, LIGHT_GRID / 2.f);
+				light.range = 2.5f;
+				light.color = hue_to_rgb(hue);
+				light.intensity = 2.f;
+				m_lights.push_back(light);
+			}
+		}
+
+		gfx::Light spot_light = {};
+		spot_light.type = gfx::LightType::Spot;
+		spot_light.position = glm::vec3(0.f, 4.f, 2.f);
+		spot_light.direction = glm::normalize(glm::vec3(0.f, -1.f, -0.5f));
+		spot_light.range = 10.f;
+		spot_light.intensity = 20.f;
+		spot_light.spot_outer = std::cos(glm::radians(25.f));
+		spot_light.spot_inner = std::cos(glm::radians(20.f));
+		m_lights.push_back(spot_light);
+	});
+
+	const auto torus = graph.add("torus", [&] {
+		std::vector<u32> indices;
+		build_torus(m_torus_vertices, indices);
+
+		std::vector<glm::vec3> positions;
+		positions.reserve(m_torus_vertices.size());
+
+		for (const auto& vertex : m_torus_vertices) {
+			positions.push_back(vertex.pos);
+		}
 
-	auto vertex_shader = m_device->get_device()->createShader(
-		nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Vertex),
-		vertex_shader_code.data(),
-		vertex_shader_code.size()
+		m_torus_meshlets = scene::MeshletBuilder::build(positions, indices);
+	});
+
+	// NOTE: only creates objects, which nvrhi allows from any thread. calls that idle the device or collect
+	// garbage (resize_swapchain, waitForIdle, runGarbageCollection) must not run while other tasks create objects
+	const auto swapchain =
+		graph.add_main("swapchain", [&] { m_device->create_swapchain(m_sdl.window); }, {window, device});
+
+	const auto create_shaders = graph.add(
+		"create_shaders",
+		[&] {
+			for (auto [idx, file] : std::views::enumerate(SHADER_FILES)) {
+				shaders[idx] = m_device->get_device()->createShader(
+					nvrhi::ShaderDesc().setShaderType(file.type),
+					shader_code[idx].data(),
+					shader_code[idx].size()
+				);
+			}
+		},
+		{device, read_shaders}
 	);
-	auto fragment_shader = m_device->get_device()->createShader(
-		nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Pixel),
-		fragment_shader_code.data(),
-		fragment_shader_code.size()
+
+	const auto lighting = graph.add(
+		"lighting",
+		[&] {
+			m_lighting = std::make_unique<gfx::ClusteredLighting>(*m_device, shader(ShaderId::LightBinning));
+		},
+		{create_shaders}
 	);
 
-	m_vertices.push_back({{-1.0f, -1.0f, 0.0f}, {0.0f, 1.0f}});
-	m_vertices.push_back({{-1.0f, 1.0f, 0.0f}, {0.0f, 0.0f}});
-	m_vertices.push_back({{1.0f, 1.0f, 0.0f}, {1.0f, 0.0f}});
-	m_vertices.push_back({{1.0f, -1.0f, 0.0f}, {1.0f, 1.0f}});
-
-	m_indices.push_back(0);
-	m_indices.push_back(1);
-	m_indices.push_back(2);
-	m_indices.push_back(2);
-	m_indices.push_back(3);
-	m_indices.push_back(0);
-
-	m_pixels.emplace_back(255, 0, 0, 255);
-	m_pixels.emplace_back(0, 255, 0, 255);
-	m_pixels.emplace_back(0, 0, 255, 255);
-	m_pixels.emplace_back(255, 255, 0, 255);
-
-	std::array<nvrhi::VertexAttributeDesc, 2> attributes = {
-		nvrhi::VertexAttributeDesc()
-			.setName("POSITION")
-			.setFormat(nvrhi::Format::RGB32_FLOAT)
-			.setOffset(offsetof(Vertex, pos))
-			.setElementStride(sizeof(Vertex)),
-		nvrhi::VertexAttributeDesc()
-			.setName("TEXCOORD")
-			.setFormat(nvrhi::Format::RG32_FLOAT)
-			.setOffset(offsetof(Vertex, uv))
-			.setElementStride(sizeof(Vertex)),
-	};
+	const auto post_process = graph.add(
+		"post_process",
+		[&] {
+			gfx::PostProcessShaders post_process_shaders = {};
+			post_process_shaders.taa = shader(ShaderId::Taa);
+			post_process_shaders.bloom_downsample = shader(ShaderId::BloomDownsample);
+			post_process_shaders.bloom_upsample = shader(ShaderId::BloomUpsample);
+			post_process_shaders.tonemap = shader(ShaderId::Tonemap);
+
+			m_post_process = std::make_unique<gfx::PostProcess>(*m_device, post_process_shaders);
+		},
+		{create_shaders}
+	);
+
+	const auto pipeline = graph.add(
+		"pipeline",
+		[&] {
+			std::array<nvrhi::VertexAttributeDesc, 3> attributes = {
+				nvrhi::VertexAttributeDesc()
+					.setName("POSITION")
+					.setFormat(nvrhi::Format::RGB32_FLOAT)
+					.setOffset(offsetof(Vertex, pos))
+					.setElementStride(sizeof(Vertex)),
+				nvrhi::VertexAttributeDesc()
+					.setName("NORMAL")
+					.setFormat(nvrhi::Format::RGB32_FLOAT)
+					.setOffset(offsetof(Vertex, normal))
+					.setElementStride(sizeof(Vertex)),
+				nvrhi::VertexAttributeDesc()
+					.setName("TEXCOORD")
+					.setFormat(nvrhi::Format::RG32_FLOAT)
+					.setOffset(offsetof(Vertex, uv))
+					.setElementStride(sizeof(Vertex)),
+			};
+
+			auto& cache = m_device->get_cache();
+
+			auto input_layout = cache.get_input_layout(attributes, shader(ShaderId::LitVertex));
+
+			nvrhi::FramebufferInfo framebuffer_info = {};
+			framebuffer_info.addColorFormat(gfx::PostProcess::COLOR_FORMAT);
+			framebuffer_info.setDepthFormat(gfx::PostProcess::DEPTH_FORMAT);
+
+			nvrhi::BindingLayoutDesc layout_desc = {};
+			layout_desc.setVisibility(nvrhi::ShaderType::All);
+			layout_desc.addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(PushConstants)));
+			layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(1));
+			layout_desc.addItem(nvrhi::BindingLayoutItem::Texture_SRV(0));
+			layout_desc.addItem(nvrhi::BindingLayoutItem::Sampler(0));
+
+			binding_layout = cache.get_binding_layout(layout_desc);
+
+			nvrhi::GraphicsPipelineDesc pipeline_desc = {};
+			pipeline_desc.setInputLayout(input_layout);
+			pipeline_desc.setVertexShader(shader(ShaderId::LitVertex));
+			pipeline_desc.setFragmentShader(shader(ShaderId::LitPixel));
+			pipeline_desc.addBindingLayout(binding_layout);
+			pipeline_desc.addBindingLayout(m_lighting->get_binding_layout());
+
+			pipeline_desc.renderState.rasterState.setCullNone();
+
+			m_pipeline = cache.get_graphics_pipeline(pipeline_desc, framebuffer_info);
+
+			// translucent draws are sorted back to front after the opaque ones, they blend without writing depth
+			auto translucent_desc = pipeline_desc;
+			translucent_desc.renderState.depthStencilState.setDepthWriteEnable(false);
+			translucent_desc.renderState.blendState.targets[0]
+				.setBlendEnable(true)
+				.setSrcBlend(nvrhi::BlendFactor::SrcAlpha)
+				.setDestBlend(nvrhi::BlendFactor::InvSrcAlpha);
+
+			m_translucent_pipeline = cache.get_graphics_pipeline(translucent_desc, framebuffer_info);
+
+			pipeline_desc.renderState.rasterState.setCullBack();
+
+			m_meshlet_pipeline = cache.get_graphics_pipeline(pipeline_desc, framebuffer_info);
+		},
+		{create_shaders, lighting}
+	);
+
+	const auto meshlets = graph.add(
+		"meshlets",
+		[&] {
+			m_torus = std::make_unique<gfx::MeshletMesh>(
+				*m_device,
+				shader(ShaderId::MeshletCull),
+				m_torus_meshlets,
+				static_cast<u32>(m_torus_vertices.size()),
+				static_cast<u32>(sizeof(Vertex))
+			);
+
+			m_use_mesh_shaders = mesh_shaders && gfx::MeshletMesh::supports_mesh_shaders(*m_device);
+			if (!m_use_mesh_shaders)
+				std::println("mesh shaders not used, meshlets are drawn with indirect draws");
+		},
+		{create_shaders, torus}
+	);
+
+	const auto overlay = graph.add(
+		"overlay",
+		[&] {
+			m_overlay = std::make_unique<gfx::TextOverlay>(
+				*m_device,
+				shader(ShaderId::OverlayVertex),
+				shader(ShaderId::OverlayPixel)
+			);
+			m_overlay_command_list = m_device->get_device()->createCommandList();
+		},
+		{create_shaders}
+	);
 
-	auto input_layout =
-		m_device->get_device()->createInputLayout(attributes.data(), static_cast<u32>(attributes.size()), vertex_shader);
-
-	nvrhi::FramebufferInfo framebuffer_info = {};
-	framebuffer_info.addColorFormat(nvrhi::Format::SRGBA8_UNORM);
-	framebuffer_info.setDepthFormat(nvrhi::Format::D32);
-
-	nvrhi::BindingLayoutDesc layout_desc = {};
-	layout_desc.setVisibility(nvrhi::ShaderType::All);
-	layout_desc.addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(PushConstants)));
-	layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(1));
-	layout_desc.addItem(nvrhi::BindingLayoutItem::Texture_SRV(0));
-	layout_desc.addItem(nvrhi::BindingLayoutItem::Sampler(0));
-
-	auto binding_layout = m_device->get_device()->createBindingLayout(layout_desc);
-
-	nvrhi::GraphicsPipelineDesc pipeline_desc = {};
-	pipeline_desc.setInputLayout(input_layout);
-	pipeline_desc.setVertexShader(vertex_shader);
-	pipeline_desc.setFragmentShader(fragment_shader);
-	pipeline_desc.addBindingLayout(binding_layout);
-	
-	pipeline_desc.renderState.rasterState.setCullNone();
-
-	m_pipeline = m_device->get_device()->createGraphicsPipeline(pipeline_desc, framebuffer_info);
-	m_command_list = m_device->get_device()->createCommandList();
-
-	nvrhi::BufferDesc constant_buffer_desc = {};
-	constant_buffer_desc.setByteSize(sizeof(UniformBuffer));
-	constant_buffer_desc.setIsConstantBuffer(true);
-	constant_buffer_desc.setIsVolatile(true);
-	constant_buffer_desc.setMaxVersions(16);
-
-	m_constant_buffer = m_device->get_device()->createBuffer(constant_buffer_desc);
-
-	nvrhi::BufferDesc vertex_buffer_desc = {};
-	vertex_buffer_desc.setByteSize(m_vertices.size() * sizeof(Vertex));
-	vertex_buffer_desc.setIsVertexBuffer(true);
-	vertex_buffer_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::VertexBuffer); // what?
-	vertex_buffer_desc.setDebugName("vertex_buffer");
-
-	m_vertex_buffer = m_device->get_device()->createBuffer(vertex_buffer_desc);
-
-	nvrhi::BufferDesc index_buffer_desc = {};
-	index_buffer_desc.setByteSize(m_indices.size() * sizeof(u32));
-	index_buffer_desc.setIsIndexBuffer(true);
-	index_buffer_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::IndexBuffer); // what?
-	index_buffer_desc.setDebugName("index_buffer");
-
-	m_index_buffer = m_device->get_device()->createBuffer(index_buffer_desc);
-
-	nvrhi::TextureDesc texture_desc = {};
-	texture_desc.setDimension(nvrhi::TextureDimension::Texture2D);
-	texture_desc.setWidth(2); // dont hardcode
-	texture_desc.setHeight(2); // dont hardcode
-	texture_desc.setFormat(nvrhi::Format::SRGBA8_UNORM);
-	texture_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource); // what?
-	texture_desc.setDebugName("texture");
-
-	m_texture = m_device->get_device()->createTexture(texture_desc);
-
-	nvrhi::SamplerDesc sampler_desc = {};
-	sampler_desc.minFilter = false;
-	sampler_desc.magFilter = false;
-
-	m_sampler = m_device->get_device()->createSampler(sampler_desc);
-
-	nvrhi::BindingSetDesc binding_set_desc = {};
-	binding_set_desc.addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(PushConstants)));
-	binding_set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(1, m_constant_buffer));
-	binding_set_desc.addItem(nvrhi::BindingSetItem::Texture_SRV(0, m_texture));
-	binding_set_desc.addItem(nvrhi::BindingSetItem::Sampler(0, m_sampler));
-
-	m_binding_set = m_device->get_device()->createBindingSet(binding_set_desc, binding_layout);
-
-	// upload data to gpu
-	m_command_list->open();
-	m_command_list->writeBuffer(m_vertex_buffer, m_vertices.data(), m_vertices.size() * sizeof(Vertex));
-	m_command_list->writeBuffer(m_index_buffer, m_indices.data(), m_indices.size() * sizeof(u32));
-	m_command_list->writeTexture(m_texture, 0, 0, m_pixels.data(), 2 * sizeof(glm::u8vec4));
-	m_command_list->close();
-	m_device->get_device()->executeCommandList(m_command_list);
+	const auto mesh_shader_pipeline = graph.add(
+		"mesh_pipeline",
+		[&] {
+			if (!m_use_mesh_shaders)
+				return;
+
+			nvrhi::FramebufferInfo framebuffer_info = {};
+			framebuffer_info.addColorFormat(gfx::PostProcess::COLOR_FORMAT);
+			framebuffer_info.setDepthFormat(gfx::PostProcess::DEPTH_FORMAT);
+
+			nvrhi::MeshletPipelineDesc pipeline_desc = {};
+			pipeline_desc.setAmplificationShader(shader(ShaderId::MeshletAmplification));
+			pipeline_desc.setMeshShader(shader(ShaderId::MeshletMesh));
+			pipeline_desc.setPixelShader(shader(ShaderId::LitPixel));
+			pipeline_desc.addBindingLayout(binding_layout);
+			pipeline_desc.addBindingLayout(m_lighting->get_binding_layout());
+			pipeline_desc.addBindingLayout(m_torus->get_binding_layout());
+
+			m_mesh_shader_pipeline = m_device->get_cache().get_meshlet_pipeline(pipeline_desc, framebuffer_info);
+		},
+		{pipeline, meshlets}
+	);
+
+	const auto resources = graph.add(
+		"resources",
+		[&] {
+			auto& memory = m_device->get_memory();
+
+			nvrhi::BufferDesc constant_buffer_desc = {};
+			constant_buffer_desc.setByteSize(sizeof(UniformBuffer));
+			constant_buffer_desc.setIsConstantBuffer(true);
+			constant_buffer_desc.setIsVolatile(true);
+			constant_buffer_desc.setMaxVersions(16);
+
+			m_constant_buffer = memory.create_buffer(constant_buffer_desc, gfx::MemoryCategory::Constant);
+
+			nvrhi::BufferDesc vertex_buffer_desc = {};
+			vertex_buffer_desc.setByteSize(m_vertices.size() * sizeof(Vertex));
+			vertex_buffer_desc.setIsVertexBuffer(true);
+			vertex_buffer_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::VertexBuffer); // what?
+			vertex_buffer_desc.setDebugName("vertex_buffer");
+
+			m_vertex_buffer = memory.create_buffer(vertex_buffer_desc, gfx::MemoryCategory::Geometry);
+
+			nvrhi::BufferDesc index_buffer_desc = {};
+			index_buffer_desc.setByteSize(m_indices.size() * sizeof(u32));
+			index_buffer_desc.setIsIndexBuffer(true);
+			index_buffer_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::IndexBuffer); // what?
+			index_buffer_desc.setDebugName("index_buffer");
+
+			m_index_buffer = memory.create_buffer(index_buffer_desc, gfx::MemoryCategory::Geometry);
+
+			nvrhi::TextureDesc texture_desc = {};
+			texture_desc.setDimension(nvrhi::TextureDimension::Texture2D);
+			texture_desc.setWidth(TEXTURE_SIZE);
+			texture_desc.setHeight(TEXTURE_SIZE);
+			texture_desc.setMipLevels(TEXTURE_MIPS);
+			texture_desc.setFormat(nvrhi::Format::SRGBA8_UNORM);
+			texture_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource); // what?
+			texture_desc.setDebugName("texture");
+
+			// NOTE: streamed, all of its mips stay on the cpu so the top ones can be dropped under budget pressure
+			m_texture = memory.create_texture(texture_desc, gfx::MemoryCategory::Streamed);
+
+			// called from MemoryManager::update, the texture is replaced once the frame's commands are open
+			memory.set_eviction_callback(m_texture, [this] { m_downgrade_texture = true; });
+
+			nvrhi::SamplerDesc sampler_desc = {};
+			sampler_desc.minFilter = false;
+			sampler_desc.magFilter = false;
+
+			m_sampler = m_device->get_cache().get_sampler(sampler_desc);
+		},
+		{device, scene}
+	);
+
+	// NOTE: the only submission during startup, it depends on every task creating device objects so none of them
+	// run concurrently with the queue
+	graph.add(
+		"upload",
+		[&] {
+			nvrhi::BindingSetDesc binding_set_desc = {};
+			binding_set_desc.addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(PushConstants)));
+			binding_set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(1, m_constant_buffer));
+			binding_set_desc.addItem(nvrhi::BindingSetItem::Texture_SRV(0, m_texture));
+			binding_set_desc.addItem(nvrhi::BindingSetItem::Sampler(0, m_sampler));
+
+			m_binding_set = m_device->get_cache().get_binding_set(binding_set_desc, binding_layout);
+
+			// upload data to gpu
+			m_command_list = m_device->get_device()->createCommandList();
+			m_command_list->open();
+			m_command_list->writeBuffer(m_vertex_buffer, m_vertices.data(), m_vertices.size() * sizeof(Vertex));
+			m_command_list->writeBuffer(m_index_buffer, m_indices.data(), m_indices.size() * sizeof(u32));
+			const u64 texture_bytes = write_texture_mips(m_command_list, m_texture, m_texture_mips);
+			m_torus->upload(m_command_list, m_torus_meshlets, std::as_bytes(std::span(m_torus_vertices)));
+			m_command_list->close();
+			m_device->get_device()->executeCommandList(m_command_list);
+
+			MetricsRegistry::global().counter("upload_bytes").add(
+				m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(u32) + texture_bytes
+			);
+		},
+		{swapchain, pipeline, resources, meshlets, mesh_shader_pipeline, lighting, post_process, overlay}
+	);
+
+	graph.run();
+	graph.report();
+
+	if (!export_options.file.empty() || !export_options.udp.empty())
+		m_metrics_exporter = std::make_unique<MetricsExporter>(MetricsRegistry::global(), export_options);
 }
 
-App::~App() {
-	if (m_window != nullptr)
-		SDL_DestroyWindow(m_window);
+SdlContext::~SdlContext() {
+	if (window != nullptr)
+		SDL_DestroyWindow(window);
 
-	SDL_Quit();
+	if (initialized)
+		SDL_Quit();
 }
 
 void App::run() {
 	m_running = true;
 	float time = 0;
+	bool first_frame = true;
+
+	// NOTE: registered once up front, recording through the references is lock-free
+	auto& registry = MetricsRegistry::global();
+	const auto frame_time_bounds = Histogram::exponential_bounds(0.25, 1.25, 32); // 0.25 ms up to ~250 ms
+
+	auto& frame_time = registry.histogram("frame_time_ms", frame_time_bounds);
+	auto& frames = registry.counter("frames");
+	auto& draw_calls = registry.counter("draw_calls");
+	auto& state_changes = registry.counter("state_changes");
+	auto& state_changes_skipped = registry.counter("state_changes_skipped");
+	auto& triangles = registry.gauge("triangles");
+	auto& visible_triangles = registry.gauge("visible_triangles");
+	auto& meshlets = registry.gauge("meshlets");
+	auto& visible_meshlets = registry.gauge("visible_meshlets");
+	auto& lights_dropped = registry.gauge("lights_dropped", "stage=upload");
+	auto& cluster_lights_dropped = registry.gauge("lights_dropped", "stage=binning");
+	auto& full_clusters = registry.gauge("full_clusters");
+	auto& upload_bytes = registry.counter("upload_bytes");
+	auto& memory_usage = registry.gauge("gpu_memory_bytes", "type=usage");
+	auto& memory_budget = registry.gauge("gpu_memory_bytes", "type=budget");
+	auto& memory_heaps = registry.gauge("gpu_memory_bytes", "type=heaps");
+	auto& memory_allocated = registry.gauge("gpu_memory_bytes", "type=allocated");
+
+	constexpr usize CACHE_TYPES = static_cast<usize>(gfx::CacheType::Count);
+	std::array<Counter*, CACHE_TYPES> cache_hits = {};
+	std::array<Counter*, CACHE_TYPES> cache_misses = {};
+	std::array<gfx::CacheStats, CACHE_TYPES> cache_reported = {}; // already added to the counters
+
+	for (usize i = 0; i < CACHE_TYPES; i++) {
+		const std::string tags = std::format("type={}", gfx::to_string(static_cast<gfx::CacheType>(i)));
+		cache_hits[i] = &registry.counter("pipeline_cache_hits", tags);
+		cache_misses[i] = &registry.counter("pipeline_cache_misses", tags);
+	}
+
+	// the overlay shows averages over the last refresh window instead of flickering per frame values
+	auto last_frame = std::chrono::steady_clock::now();
+	auto overlay_refresh = last_frame;
+	HistogramSnapshot overlay_frame_times = frame_time.snapshot();
+	u64 overlay_upload_bytes = upload_bytes.get();
 
 	while (m_running) {
 		SDL_Event event;
+		std::optional<glm::vec2> pick;
 
 		while (SDL_PollEvent(&event)) {
 			switch (event.type) {
@@ -208,6 +651,15 @@ void App::run() {
 				case SDL_EVENT_WINDOW_RESIZED:
 					m_device->resize_swapchain();
 					break;
+				case SDL_EVENT_MOUSE_BUTTON_DOWN:
+					// NOTE: mouse positions are in window coordinates, the framebuffer is in pixels
+					if (event.button.button == SDL_BUTTON_LEFT)
+						pick = glm::vec2(event.button.x, event.button.y) * SDL_GetWindowPixelDensity(m_sdl.window);
+					break;
+				case SDL_EVENT_KEY_DOWN:
+					if (event.key.key == SDLK_F3)
+						m_show_overlay = !m_show_overlay;
+					break;
 				default:
 					break;
 			}
@@ -217,57 +669,341 @@ void App::run() {
 		auto framebuffer = m_device->begin_frame();
 		const auto width = static_cast<float>(framebuffer->getFramebufferInfo().width);
 		const auto height = static_cast<float>(framebuffer->getFramebufferInfo().height);
+		const auto scene_framebuffer = m_post_process->begin_frame(static_cast<u32>(width), static_cast<u32>(height));
+
+		u32 draws = 0;
+		u32 state_change_count = 0;
+		u32 state_changes_skipped_count = 0;
+		u32 quad_triangles = 0;
+
+		m_objects[0].model = glm::rotate(glm::mat4(1.f), time * glm::radians(90.f), glm::vec3(0, 1, 0));
+		m_bvh.update(m_objects[0].proxy, QUAD_BOUNDS.transform(m_objects[0].model));
+
+		for (auto [idx, light] : std::views::enumerate(m_lights)) {
+			if (light.type != gfx::LightType::Point)
+				continue;
+
+			const f32 phase = time + static_cast<f32>(idx) * 0.37f;
+			light.position.y = -1.2f + 0.2f * std::sin(phase * 2.f);
+		}
 
 		m_command_list->open();
 
-		nvrhi::utils::ClearColorAttachment(m_command_list, framebuffer, 0, nvrhi::Color(0.f));
-		nvrhi::utils::ClearDepthStencilAttachment(m_command_list, framebuffer, 1.0f, 0);
+		if (m_downgrade_texture) {
+			downgrade_texture();
+			m_downgrade_texture = false;
+		}
+
+		nvrhi::utils::ClearColorAttachment(m_command_list, scene_framebuffer, 0, nvrhi::Color(0.f));
+		nvrhi::utils::ClearDepthStencilAttachment(m_command_list, scene_framebuffer, 1.0f, 0);
 
 		PushConstants push_constants = {};
 		UniformBuffer uniform_buffer = {};
 
-		uniform_buffer.view = glm::lookAt(glm::vec3(2, 1.8, 5), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-		uniform_buffer.projection = glm::perspective(glm::radians(45.0f), width / height, 0.1f, 1000.f);
+		const glm::vec3 camera_position = glm::vec3(2, 1.8, 5);
+
+		uniform_buffer.view = glm::lookAt(camera_position, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+		const glm::mat4 projection = glm::perspective(glm::radians(45.0f), width / height, NEAR_PLANE, FAR_PLANE);
+		uniform_buffer.projection = m_post_process->jitter(projection);
 
 		m_command_list->writeBuffer(m_constant_buffer, &uniform_buffer, sizeof(UniformBuffer));
+		upload_bytes.add(sizeof(UniformBuffer));
+
+		const glm::mat4 view_projection = projection * uniform_buffer.view;
+
+		if (pick) {
+			const glm::mat4 inverse = glm::inverse(view_projection);
+			const glm::vec2 ndc = glm::vec2(pick->x / width * 2.f - 1.f, 1.f - pick->y / height * 2.f);
+
+			const glm::vec4 near_point = inverse * glm::vec4(ndc, 0.f, 1.f);
+			const glm::vec4 far_point = inverse * glm::vec4(ndc, 1.f, 1.f);
+
+			scene::Ray ray;
+			ray.origin = glm::vec3(near_point) / near_point.w;
+			ray.direction = glm::normalize(glm::vec3(far_point) / far_point.w - ray.origin);
+
+			m_picked = m_bvh.raycast(ray);
+		}
+
+		m_lighting->update(
+			m_command_list,
+			uniform_buffer.view,
+			projection,
+			NEAR_PLANE,
+			FAR_PLANE,
+			static_cast<u32>(width),
+			static_cast<u32>(height),
+			m_lights
+		);
+
+		m_visible_objects.clear();
+		m_bvh.query_frustum(scene::Frustum::from_matrix(view_projection), m_visible_objects);
+
+		m_torus_instances.clear();
+		m_torus_objects.clear();
+
+		for (const u32 id : m_visible_objects) {
+			if (m_objects[id].mesh != MeshId::Torus)
+				continue;
+
+			m_torus_objects.push_back(id);
+			m_torus_instances.push_back(m_objects[id].model);
+		}
 
-		nvrhi::GraphicsState state;
-		state.setPipeline(m_pipeline);
-		state.setFramebuffer(framebuffer);
-		state.setViewport(nvrhi::ViewportState().addViewportAndScissorRect(nvrhi::Viewport(width, height)));
-		state.addBindingSet(m_binding_set);
+		// meshlets of the visible tori are culled again on the gpu, against the frustum and their normal cones
+		m_torus->update(m_command_list, view_projection, camera_position, m_torus_instances);
+		if (!m_use_mesh_shaders)
+			m_torus->cull(m_command_list);
 
-		state.setIndexBuffer({m_index_buffer, nvrhi::Format::R32_UINT, 0});
-		state.addVertexBuffer({m_vertex_buffer, 0, offsetof(Vertex, pos)});
-		state.addVertexBuffer({m_vertex_buffer, 1, offsetof(Vertex, uv)});
+		const auto viewport = nvrhi::ViewportState().addViewportAndScissorRect(nvrhi::Viewport(width, height));
+		m_draw_queue.begin(scene_framebuffer, viewport);
 
-		m_command_list->setGraphicsState(state);
+		gfx::DrawItem draw = {};
+		draw.binding_sets = {m_binding_set, m_lighting->get_binding_set()};
+		draw.vertex_buffer = m_vertex_buffer;
+		draw.index_buffer = m_index_buffer;
+		draw.args.setVertexCount(static_cast<u32>(m_indices.size()));
 
-		push_constants.tint = glm::vec4(1.f);
-		push_constants.model = 1.f;
-		push_constants.model = glm::rotate(push_constants.model, time * glm::radians(90.f), glm::vec3(0, 1, 0));
+		const auto submit = [&](const PushConstants& constants) {
+			const f32 depth = -(uniform_buffer.view * constants.model[3]).z;
+			const bool translucent = constants.tint.a < 1.f;
 
-		m_command_list->setPushConstants(&push_constants, sizeof(PushConstants));
-		m_command_list->drawIndexed(nvrhi::DrawArguments().setVertexCount(static_cast<u32>(m_indices.size())));
+			draw.pipeline = translucent ? m_translucent_pipeline : m_pipeline;
+			draw.set_push_constants(constants);
+			m_draw_queue.submit(draw, gfx::DrawLayer::Scene, translucent, depth);
+		};
 
-		push_constants.tint = glm::vec4(.1f, .1f, .1f, 1.f);
-		push_constants.model = 1.f;
-		push_constants.model = glm::translate(push_constants.model, glm::vec3(0, -1.5, 0));
-		push_constants.model = glm::rotate(push_constants.model, glm::radians(-90.f), glm::vec3(1, 0, 0));
-		push_constants.model = glm::scale(push_constants.model, glm::vec3(20.f));
+		for (const u32 id : m_visible_objects) {
+			if (m_objects[id].mesh != MeshId::Quad)
+				continue;
 
-		m_command_list->setPushConstants(&push_constants, sizeof(PushConstants));
-		m_command_list->drawIndexed(nvrhi::DrawArguments().setVertexCount(static_cast<u32>(m_indices.size())));
+			push_constants.model = m_objects[id].model;
+			push_constants.tint = m_objects[id].tint;
+			submit(push_constants);
+
+			quad_triangles += static_cast<u32>(m_indices.size()) / 3;
+		}
+
+		const u32 torus_count = m_torus->get_instance_count();
+
+		if (!m_use_mesh_shaders) {
+			for (u32 instance = 0; instance < torus_count; instance++) {
+				const Object& object = m_objects[m_torus_objects[instance]];
+
+				gfx::DrawItem torus_draw = m_torus->get_draw_item(instance);
+				torus_draw.pipeline = m_meshlet_pipeline;
+				torus_draw.binding_sets = {m_binding_set, m_lighting->get_binding_set()};
+				torus_draw.set_push_constants(PushConstants {object.model, object.tint});
+
+				const f32 depth = -(uniform_buffer.view * object.model[3]).z;
+				m_draw_queue.submit(torus_draw, gfx::DrawLayer::Scene, false, depth);
+			}
+		}
+
+		m_draw_queue.flush(m_command_list);
+
+		// NOTE: every scene draw binds the texture, touching it keeps it off the eviction list while it is on screen
+		if (quad_triangles > 0 || torus_count > 0)
+			m_device->get_memory().touch(m_texture);
+
+		draws += m_draw_queue.get_stats().draws;
+		state_change_count += m_draw_queue.get_stats().state_changes;
+		state_changes_skipped_count += m_draw_queue.get_stats().state_changes_skipped;
+
+		if (m_use_mesh_shaders && torus_count > 0) {
+			nvrhi::MeshletState state;
+			state.setPipeline(m_mesh_shader_pipeline);
+			state.setFramebuffer(scene_framebuffer);
+			state.setViewport(viewport);
+			state.addBindingSet(m_binding_set);
+			state.addBindingSet(m_lighting->get_binding_set());
+			state.addBindingSet(m_torus->get_binding_set());
+
+			m_command_list->setMeshletState(state);
+
+			for (u32 instance = 0; instance < torus_count; instance++) {
+				const Object& object = m_objects[m_torus_objects[instance]];
+
+				push_constants.model = object.model;
+				push_constants.tint = object.tint;
+
+				m_command_list->setPushConstants(&push_constants, sizeof(PushConstants));
+				m_command_list->dispatchMesh(m_torus->get_task_group_count());
+			}
+
+			draws += torus_count;
+			state_change_count++;
+		}
+
+		m_torus->resolve_stats(m_command_list);
 
 		m_command_list->close();
 
-		m_device->get_device()->executeCommandList(m_command_list);
+		m_post_process->execute(m_command_list, view_projection, framebuffer);
+
+		// NOTE: drawn straight onto the swapchain, so the text is not tonemapped or blurred by taa
+		if (m_show_overlay) {
+			m_overlay_command_list->open();
+			m_draw_queue.begin(framebuffer, viewport);
+			m_overlay->submit(m_overlay_command_list, m_draw_queue, framebuffer);
+			m_draw_queue.flush(m_overlay_command_list);
+			m_overlay_command_list->close();
+			m_device->get_device()->executeCommandList(m_overlay_command_list);
+
+			draws += m_draw_queue.get_stats().draws;
+			state_change_count += m_draw_queue.get_stats().state_changes;
+			state_changes_skipped_count += m_draw_queue.get_stats().state_changes_skipped;
+		}
+
 		m_device->end_frame();
 
+		const auto now = std::chrono::steady_clock::now();
+		frame_time.record(std::chrono::duration<f64, std::milli>(now - last_frame).count());
+		last_frame = now;
+
+		frames.add();
+		draw_calls.add(draws);
+		state_changes.add(state_change_count);
+		state_changes_skipped.add(state_changes_skipped_count);
+
+		const auto& meshlet_stats = m_torus->get_stats();
+		triangles.set(quad_triangles + meshlet_stats.triangles);
+		visible_triangles.set(quad_triangles + meshlet_stats.visible_triangles);
+		meshlets.set(meshlet_stats.meshlets);
+		visible_meshlets.set(meshlet_stats.visible_meshlets);
+
+		const auto& lighting_stats = m_lighting->get_stats();
+		lights_dropped.set(lighting_stats.dropped_lights);
+		cluster_lights_dropped.set(lighting_stats.dropped_cluster_lights);
+		full_clusters.set(lighting_stats.full_clusters);
+
+		const auto memory_stats = m_device->get_memory().get_stats();
+		memory_usage.set(static_cast<f64>(memory_stats.budget.usage));
+		memory_budget.set(static_cast<f64>(memory_stats.budget.budget));
+		memory_heaps.set(static_cast<f64>(memory_stats.heap_bytes));
+		memory_allocated.set(static_cast<f64>(memory_stats.allocated_bytes));
+
+		auto& cache = m_device->get_cache();
+		u64 cache_hit_count = 0;
+		u64 cache_miss_count = 0;
+
+		for (usize i = 0; i < CACHE_TYPES; i++) {
+			const gfx::CacheStats stats = cache.get_stats(static_cast<gfx::CacheType>(i));
+			cache_hits[i]->add(stats.hits - cache_reported[i].hits);
+			cache_misses[i]->add(stats.misses - cache_reported[i].misses);
+			cache_reported[i] = stats;
+
+			cache_hit_count += stats.hits;
+			cache_miss_count += stats.misses;
+		}
+
+		if (m_show_overlay && now - overlay_refresh >= OVERLAY_REFRESH) {
+			const HistogramSnapshot frame_times = frame_time.snapshot();
+			const HistogramSnapshot window = frame_times.since(overlay_frame_times);
+			const u64 window_upload_bytes = upload_bytes.get() - overlay_upload_bytes;
+
+			const f64 mean = window.mean();
+			const f64 p95 = window.percentile(0.95);
+			const f64 hit_rate = 100.0 * cache_hit_count / std::max<u64>(cache_hit_count + cache_miss_count, 1);
+			const u64 usage = memory_stats.budget.usage;
+			const u64 budget = memory_stats.budget.budget;
+
+			u32 frame_color = gfx::TextOverlay::WHITE;
+			if (p95 > 2.0 * FRAME_BUDGET_MS)
+				frame_color = gfx::TextOverlay::RED;
+			else if (p95 > FRAME_BUDGET_MS)
+				frame_color = gfx::TextOverlay::YELLOW;
+
+			m_overlay->clear();
+			m_overlay->add_line(
+				std::format("frame {:.2f} ms  p95 {:.2f} ms  {:.0f} fps", mean, p95, mean > 0.0 ? 1000.0 / mean : 0.0),
+				frame_color
+			);
+			m_overlay->add_line(
+				std::format(
+					"draws {}  state changes {}  skipped {}",
+					draws,
+					state_change_count,
+					state_changes_skipped_count
+				)
+			);
+			m_overlay->add_line(
+				std::format(
+					"triangles {} / {} visible",
+					quad_triangles + meshlet_stats.visible_triangles,
+					quad_triangles + meshlet_stats.triangles
+				)
+			);
+			m_overlay->add_line(
+				std::format(
+					"meshlets {} / {} visible  {}",
+					meshlet_stats.visible_meshlets,
+					meshlet_stats.meshlets,
+					m_use_mesh_shaders ? "mesh shaders" : "indirect"
+				)
+			);
+			const bool lights_truncated = lighting_stats.dropped_lights + lighting_stats.full_clusters > 0;
+			m_overlay->add_line(
+				std::format(
+					"lights {}  dropped {}  full clusters {}",
+					lighting_stats.lights,
+					lighting_stats.dropped_lights + lighting_stats.dropped_cluster_lights,
+					lighting_stats.full_clusters
+				),
+				lights_truncated ? gfx::TextOverlay::YELLOW : gfx::TextOverlay::WHITE
+			);
+			m_overlay->add_line(
+				std::format("uploads {:.1f} kb/frame", window_upload_bytes / 1024.0 / std::max<u64>(window.count, 1))
+			);
+			m_overlay->add_line(
+				std::format("gpu memory {:.0f} / {:.0f} mb", usage / MEGABYTE, budget / MEGABYTE),
+				usage > budget ? gfx::TextOverlay::RED : gfx::TextOverlay::WHITE
+			);
+			m_overlay->add_line(std::format("pipeline cache {:.1f}% hits  {} misses", hit_rate, cache_miss_count));
+
+			if (m_picked.hit())
+				m_overlay->add_line(std::format("picked object {} at {:.2f}", m_picked.user_data, m_picked.t));
+
+			overlay_frame_times = frame_times;
+			overlay_upload_bytes += window_upload_bytes;
+			overlay_refresh = now;
+		}
+
+		if (first_frame) {
+			const std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - m_start_time;
+			std::println("time to first frame: {:.2f} ms", elapsed.count());
+			registry.gauge("time_to_first_frame_ms").set(elapsed.count());
+			first_frame = false;
+		}
+
 		time += 1.0f / 60.0f;
 	}
 }
 
+// Drops the top mips of the texture, the rest of the chain is uploaded again into a smaller texture.
+// the replacement is not evictable, it is already at the smallest size the texture streams down to
+void App::downgrade_texture() {
+	nvrhi::TextureDesc texture_desc = m_texture->getDesc();
+	texture_desc.setWidth(TEXTURE_SIZE >> EVICTED_MIP);
+	texture_desc.setHeight(TEXTURE_SIZE >> EVICTED_MIP);
+	texture_desc.setMipLevels(TEXTURE_MIPS - EVICTED_MIP);
+
+	m_texture = m_device->get_memory().create_texture(texture_desc, gfx::MemoryCategory::Streamed);
+
+	const auto mips = std::span(m_texture_mips).subspan(EVICTED_MIP);
+	MetricsRegistry::global().counter("upload_bytes").add(write_texture_mips(m_command_list, m_texture, mips));
+
+	nvrhi::BindingSetDesc binding_set_desc = *m_binding_set->getDesc();
+	for (auto& item : binding_set_desc.bindings) {
+		if (item.type == nvrhi::ResourceType::Texture_SRV)
+			item.resourceHandle = m_texture;
+	}
+
+	// NOTE: the memory manager already dropped the cached set holding the old texture, so replacing ours
+	// releases the last reference and the old texture is freed once in-flight frames are done with it
+	m_binding_set = m_device->get_cache().get_binding_set(binding_set_desc, m_binding_set->getLayout());
+}
+
 void App::quit() {
 	m_running = false;
 }
@@ -1,9 +1,11 @@
 #include <nvrhi/d3d12.h>
 #include <nvrhi/validation.h>
 
+#include <format>
 #include <print>
 
 #include "backends/dx12/device.hpp"
+#include "metrics.hpp"
 
 template<>
 struct std::formatter<D3D12_MESSAGE_SEVERITY> : std::formatter<std::string_view> {
@@ -29,15 +31,24 @@ struct std::formatter<D3D12_MESSAGE_SEVERITY> : std::formatter<std::string_view>
 namespace vg::gfx {
 
 #ifndef NDEBUG
-static void callback(D3D12_MESSAGE_CATEGORY, D3D12_MESSAGE_SEVERITY severity, D3D12_MESSAGE_ID, LPCSTR msg, void*) {
-	if (severity <= D3D12_MESSAGE_SEVERITY_INFO)
+// context is the device's counter array, indexed by severity
+static void callback(
+	D3D12_MESSAGE_CATEGORY,
+	D3D12_MESSAGE_SEVERITY severity,
+	D3D12_MESSAGE_ID,
+	LPCSTR msg,
+	void* context
+) {
+	// NOTE: severities count down from corruption, so info and message are the two least severe
+	if (severity >= D3D12_MESSAGE_SEVERITY_INFO)
 		return;
 
 	std::println("[d3d12][{}]: {}", severity, msg);
+	static_cast<Counter**>(context)[severity]->add();
 }
 #endif
 
-DX12Device::DX12Device() {
+DX12Device::DX12Device([[maybe_unused]] const DeviceOptions& options) {
 #ifdef NDEBUG
 	std::ignore = CreateDXGIFactory2(0, IID_PPV_ARGS(&m_factory));
 #else
@@ -46,17 +57,27 @@ DX12Device::DX12Device() {
 	nvrhi::RefCountPtr<ID3D12Debug3> debug;
 	std::ignore = D3D12GetDebugInterface(IID_PPV_ARGS(&debug));
 	debug->EnableDebugLayer();
-	debug->SetEnableGPUBasedValidation(true);
+	debug->SetEnableGPUBasedValidation(options.gpu_validation);
 #endif
 
 	std::ignore = m_factory->EnumAdapters(0, &m_adapter);
 	std::ignore = D3D12CreateDevice(m_adapter, D3D_FEATURE_LEVEL_12_0, IID_PPV_ARGS(&m_device));
 
 #ifndef NDEBUG
+	for (u32 i = 0; i < m_d3d12_message_counters.size(); i++) {
+		const auto severity = static_cast<D3D12_MESSAGE_SEVERITY>(i);
+		m_d3d12_message_counters[i] =
+			&MetricsRegistry::global().counter("device_messages", std::format("source=d3d12,severity={}", severity));
+	}
+
 	nvrhi::RefCountPtr<ID3D12InfoQueue1> info_queue;
 	std::ignore = m_device->QueryInterface(IID_PPV_ARGS(&info_queue));
-	std::ignore =
-		info_queue->RegisterMessageCallback(callback, D3D12_MESSAGE_CALLBACK_IGNORE_FILTERS, this, &m_debug_cookie);
+	std::ignore = info_queue->RegisterMessageCallback(
+		callback,
+		D3D12_MESSAGE_CALLBACK_IGNORE_FILTERS,
+		m_d3d12_message_counters.data(),
+		&m_debug_cookie
+	);
 
 	if (info_queue) {
 		// std::ignore = info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, true);
@@ -99,12 +120,15 @@ DX12Device::DX12Device() {
 #ifndef NDEBUG
 	m_handle = nvrhi::validation::createValidationLayer(m_handle);
 #endif
+
+	m_memory = std::make_unique<MemoryManager>(*this);
+	m_cache = std::make_unique<PipelineCache>(m_handle);
 }
 
 DX12Device::~DX12Device() {
 	if (m_handle) {
 		m_handle->waitForIdle();
-		IDevice::~IDevice(); // this feels wrong
+		destroy_resources();
 	}
 
 #ifndef NDEBUG
@@ -149,7 +173,10 @@ void DX12Device::create_swapchain(SDL_Window* window) {
 			->CreateSwapChainForHwnd(m_graphics_queue, handle, &m_swapchain_desc, &m_fullscreen_desc, nullptr, &swapchain);
 	std::ignore = swapchain->QueryInterface(IID_PPV_ARGS(&m_swapchain));
 
+	// NOTE: may run while other threads create device objects, so the targets are created directly
+	// instead of through resize_swapchain, which idles the device
 	create_render_targets();
+	create_framebuffers();
 
 	std::ignore = m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
 
@@ -258,9 +285,10 @@ void DX12Device::present_frame() {
 	const UINT index = m_swapchain->GetCurrentBackBufferIndex();
 	std::ignore = m_swapchain->Present(1, 0);
 
-	std::ignore = m_fence->SetEventOnCompletion(m_frame_count, m_swapchain_events[index]);
-	std::ignore = m_graphics_queue->Signal(m_fence, m_frame_count);
-	m_frame_count++;
+	// NOTE: the fence starts at 0, so frame N signals N + 1
+	const u64 fence_value = m_frame_index + 1;
+	std::ignore = m_fence->SetEventOnCompletion(fence_value, m_swapchain_events[index]);
+	std::ignore = m_graphics_queue->Signal(m_fence, fence_value);
 }
 
 u32 DX12Device::get_current_index() {
@@ -279,4 +307,16 @@ nvrhi::DeviceHandle DX12Device::get_device() {
 	return m_handle;
 }
 
+MemoryBudget DX12Device::query_memory_budget() {
+	nvrhi::RefCountPtr<IDXGIAdapter3> adapter;
+	if (FAILED(m_adapter->QueryInterface(IID_PPV_ARGS(&adapter))))
+		return {};
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+	if (FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+		return {};
+
+	return {info.Budget, info.CurrentUsage};
+}
+
 } // namespace vg::gfx
@@ -3,6 +3,7 @@
 #include <d3d12.h>
 #include <dxgi1_5.h>
 
+#include <array>
 #include <vector>
 
 #include "gfx/device.hpp"
@@ -11,7 +12,7 @@ namespace vg::gfx {
 
 class DX12Device final : public IDevice {
   public:
-	DX12Device();
+	explicit DX12Device(const DeviceOptions& options);
 	~DX12Device() override;
 
 	void create_swapchain(SDL_Window* window) override;
@@ -28,6 +29,7 @@ class DX12Device final : public IDevice {
 	u32 get_buffer_count() override;
 	nvrhi::TextureHandle get_buffer(u32 index) override;
 	nvrhi::DeviceHandle get_device() override;
+	MemoryBudget query_memory_budget() override;
 
   private:
 	nvrhi::DeviceHandle m_handle;
@@ -37,6 +39,7 @@ class DX12Device final : public IDevice {
 	nvrhi::RefCountPtr<ID3D12Device> m_device;
 
 	DWORD m_debug_cookie = 0;
+	std::array<Counter*, D3D12_MESSAGE_SEVERITY_INFO> m_d3d12_message_counters = {}; // corruption, error, warning
 
 	nvrhi::RefCountPtr<ID3D12CommandQueue> m_graphics_queue;
 	nvrhi::RefCountPtr<ID3D12CommandQueue> m_compute_queue;
@@ -51,8 +54,6 @@ class DX12Device final : public IDevice {
 	std::vector<nvrhi::RefCountPtr<ID3D12Resource>> m_swapchain_buffers;
 	std::vector<nvrhi::TextureHandle> m_swapchain_textures;
 	std::vector<HANDLE> m_swapchain_events;
-
-	u64 m_frame_count = 1;
 };
 
 } // namespace vg::gfx
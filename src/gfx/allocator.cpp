@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <bit>
+
+#include "gfx/allocator.hpp"
+
+namespace vg::gfx {
+
+static u64 align_up(const u64 value, const u64 alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+TlsfAllocator::TlsfAllocator(const u64 capacity, const u64 granularity) :
+	m_capacity(capacity / granularity * granularity), m_granularity(granularity) {
+	for (auto& heads : m_free_heads) {
+		heads.fill(INVALID_NODE);
+	}
+
+	if (m_capacity > 0) {
+		insert_free(create_block(0, m_capacity));
+	}
+}
+
+std::optional<TlsfAllocator::Allocation> TlsfAllocator::allocate(u64 size, u64 alignment) {
+	if (size == 0)
+		return std::nullopt;
+
+	size = align_up(size, m_granularity);
+	alignment = align_up(std::max(alignment, m_granularity), m_granularity);
+
+	// NOTE: over-allocate so any block we find can be aligned by splitting off the front
+	const u64 padded = alignment > m_granularity ? size + alignment - m_granularity : size;
+	if (padded > m_capacity - m_used)
+		return std::nullopt;
+
+	u32 node = find_free(padded);
+	if (node == INVALID_NODE)
+		return std::nullopt;
+
+	remove_free(node);
+
+	const u64 aligned = align_up(m_blocks[node].offset, alignment);
+	if (aligned != m_blocks[node].offset) {
+		const u32 front = node;
+		node = split(front, aligned - m_blocks[front].offset);
+		insert_free(front);
+	}
+
+	if (m_blocks[node].size > size) {
+		insert_free(split(node, size));
+	}
+
+	m_used += m_blocks[node].size;
+
+	return Allocation {m_blocks[node].offset, m_blocks[node].size, node};
+}
+
+void TlsfAllocator::free(const Allocation& allocation) {
+	u32 node = allocation.node;
+	if (node == INVALID_NODE)
+		return;
+
+	m_used -= m_blocks[node].size;
+
+	const u32 prev = m_blocks[node].prev_phys;
+	if (prev != INVALID_NODE && m_blocks[prev].free) {
+		remove_free(prev);
+
+		m_blocks[prev].size += m_blocks[node].size;
+		m_blocks[prev].next_phys = m_blocks[node].next_phys;
+		if (m_blocks[prev].next_phys != INVALID_NODE)
+			m_blocks[m_blocks[prev].next_phys].prev_phys = prev;
+
+		destroy_block(node);
+		node = prev;
+	}
+
+	const u32 next = m_blocks[node].next_phys;
+	if (next != INVALID_NODE && m_blocks[next].free) {
+		remove_free(next);
+
+		m_blocks[node].size += m_blocks[next].size;
+		m_blocks[node].next_phys = m_blocks[next].next_phys;
+		if (m_blocks[node].next_phys != INVALID_NODE)
+			m_blocks[m_blocks[node].next_phys].prev_phys = node;
+
+		destroy_block(next);
+	}
+
+	insert_free(node);
+}
+
+void TlsfAllocator::mapping(const u64 size, u32& fl, u32& sl) {
+	if (size < SL_COUNT) {
+		fl = 0;
+		sl = static_cast<u32>(size);
+	} else {
+		const u32 log = 63 - static_cast<u32>(std::countl_zero(size));
+		sl = static_cast<u32>(size >> (log - SL_BITS)) ^ SL_COUNT;
+		fl = log - SL_BITS + 1;
+	}
+}
+
+u32 TlsfAllocator::create_block(const u64 offset, const u64 size) {
+	u32 node;
+
+	if (!m_unused_nodes.empty()) {
+		node = m_unused_nodes.back();
+		m_unused_nodes.pop_back();
+	} else {
+		node = static_cast<u32>(m_blocks.size());
+		m_blocks.emplace_back();
+	}
+
+	m_blocks[node] = {};
+	m_blocks[node].offset = offset;
+	m_blocks[node].size = size;
+
+	return node;
+}
+
+void TlsfAllocator::destroy_block(const u32 node) {
+	m_blocks[node] = {};
+	m_unused_nodes.push_back(node);
+}
+
+void TlsfAllocator::insert_free(const u32 node) {
+	u32 fl, sl;
+	mapping(m_blocks[node].size, fl, sl);
+
+	const u32 head = m_free_heads[fl][sl];
+
+	m_blocks[node].free = true;
+	m_blocks[node].prev_free = INVALID_NODE;
+	m_blocks[node].next_free = head;
+
+	if (head != INVALID_NODE)
+		m_blocks[head].prev_free = node;
+
+	m_free_heads[fl][sl] = node;
+	m_sl_bitmap[fl] |= 1u << sl;
+	m_fl_bitmap |= u64(1) << fl;
+}
+
+void TlsfAllocator::remove_free(const u32 node) {
+	u32 fl, sl;
+	mapping(m_blocks[node].size, fl, sl);
+
+	const u32 prev = m_blocks[node].prev_free;
+	const u32 next = m_blocks[node].next_free;
+
+	if (prev != INVALID_NODE)
+		m_blocks[prev].next_free = next;
+	if (next != INVALID_NODE)
+		m_blocks[next].prev_free = prev;
+
+	if (m_free_heads[fl][sl] == node) {
+		m_free_heads[fl][sl] = next;
+
+		if (next == INVALID_NODE) {
+			m_sl_bitmap[fl] &= ~(1u << sl);
+			if (m_sl_bitmap[fl] == 0)
+				m_fl_bitmap &= ~(u64(1) << fl);
+		}
+	}
+
+	m_blocks[node].free = false;
+	m_blocks[node].prev_free = INVALID_NODE;
+	m_blocks[node].next_free = INVALID_NODE;
+}
+
+u32 TlsfAllocator::find_free(u64 size) {
+	// round up to the next bin so every block in the chosen bin is large enough
+	if (size >= SL_COUNT) {
+		const u32 log = 63 - static_cast<u32>(std::countl_zero(size));
+		size += (u64(1) << (log - SL_BITS)) - 1;
+	}
+
+	u32 fl, sl;
+	mapping(size, fl, sl);
+
+	u32 sl_map = m_sl_bitmap[fl] & (~0u << sl);
+	if (sl_map == 0) {
+		if (fl + 1 >= FL_COUNT)
+			return INVALID_NODE;
+
+		const u64 fl_map = m_fl_bitmap & (~u64(0) << (fl + 1));
+		if (fl_map == 0)
+			return INVALID_NODE;
+
+		fl = static_cast<u32>(std::countr_zero(fl_map));
+		sl_map = m_sl_bitmap[fl];
+	}
+
+	sl = static_cast<u32>(std::countr_zero(sl_map));
+	return m_free_heads[fl][sl];
+}
+
+u32 TlsfAllocator::split(const u32 node, const u64 size) {
+	const u32 tail = create_block(m_blocks[node].offset + size, m_blocks[node].size - size);
+
+	m_blocks[tail].prev_phys = node;
+	m_blocks[tail].next_phys = m_blocks[node].next_phys;
+	if (m_blocks[tail].next_phys != INVALID_NODE)
+		m_blocks[m_blocks[tail].next_phys].prev_phys = tail;
+
+	m_blocks[node].next_phys = tail;
+	m_blocks[node].size = size;
+
+	return tail;
+}
+
+} // namespace vg::gfx
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+#include "gfx/cache.hpp"
+
+namespace vg::gfx {
+
+std::string_view to_string(const CacheType type) {
+	switch (type) {
+		case CacheType::InputLayout:
+			return "input_layout";
+		case CacheType::BindingLayout:
+			return "binding_layout";
+		case CacheType::Sampler:
+			return "sampler";
+		case CacheType::BindingSet:
+			return "binding_set";
+		case CacheType::GraphicsPipeline:
+			return "graphics_pipeline";
+		case CacheType::MeshletPipeline:
+			return "meshlet_pipeline";
+		case CacheType::ComputePipeline:
+			return "compute_pipeline";
+		default:
+			return "unknown";
+	}
+}
+
+// NOTE: every descriptor lists its fields once, hashing it and comparing it on a hit both walk the same list.
+// the visitor is called with the matching field of both descriptors
+struct Hasher {
+	usize seed = 0;
+
+	template<typename T>
+	void operator()(const T& value, const T&) {
+		nvrhi::hash_combine(seed, value);
+	}
+};
+
+struct Comparer {
+	bool equal = true;
+
+	template<typename T>
+	void operator()(const T& a, const T& b) {
+		equal = equal && a == b;
+	}
+};
+
+template<typename Visit, typename List, typename Item>
+static void visit_list(Visit& visit, const List& a, const List& b, Item&& item) {
+	visit(a.size(), b.size());
+
+	for (usize i = 0; i < std::min(a.size(), b.size()); i++) {
+		item(a[i], b[i]);
+	}
+}
+
+template<typename Visit>
+static void visit_fields(
+	Visit& visit,
+	std::span<const nvrhi::VertexAttributeDesc> a,
+	nvrhi::IShader* a_vertex_shader,
+	std::span<const nvrhi::VertexAttributeDesc> b,
+	nvrhi::IShader* b_vertex_shader
+) {
+	visit_list(visit, a, b, [&](const nvrhi::VertexAttributeDesc& x, const nvrhi::VertexAttributeDesc& y) {
+		visit(x.name, y.name);
+		visit(x.format, y.format);
+		visit(x.arraySize, y.arraySize);
+		visit(x.bufferIndex, y.bufferIndex);
+		visit(x.offset, y.offset);
+		visit(x.elementStride, y.elementStride);
+		visit(x.isInstanced, y.isInstanced);
+	});
+
+	visit(a_vertex_shader, b_vertex_shader);
+}
+
+template<typename Visit>
+static void visit_fields(Visit& visit, const nvrhi::BindingLayoutDesc& a, const nvrhi::BindingLayoutDesc& b) {
+	visit(a.visibility, b.visibility);
+	visit(a.registerSpace, b.registerSpace);
+	visit(a.registerSpaceIsDescriptorSet, b.registerSpaceIsDescriptorSet);
+
+	const auto visit_item = [&](const nvrhi::BindingLayoutItem& x, const nvrhi::BindingLayoutItem& y) {
+		visit(x.slot, y.slot);
+		visit(x.type, y.type);
+		visit(x.size, y.size);
+	};
+
+	visit_list(visit, a.bindings, b.bindings, visit_item);
+
+	visit(a.bindingOffsets.shaderResource, b.bindingOffsets.shaderResource);
+	visit(a.bindingOffsets.sampler, b.bindingOffsets.sampler);
+	visit(a.bindingOffsets.constantBuffer, b.bindingOffsets.constantBuffer);
+	visit(a.bindingOffsets.unorderedAccess, b.bindingOffsets.unorderedAccess);
+}
+
+template<typename Visit>
+static void visit_fields(Visit& visit, const nvrhi::SamplerDesc& a, const nvrhi::SamplerDesc& b) {
+	visit(a.borderColor.r, b.borderColor.r);
+	visit(a.borderColor.g, b.borderColor.g);
+	visit(a.borderColor.b, b.borderColor.b);
+	visit(a.borderColor.a, b.borderColor.a);
+	visit(a.maxAnisotropy, b.maxAnisotropy);
+	visit(a.mipBias, b.mipBias);
+	visit(a.minFilter, b.minFilter);
+	visit(a.magFilter, b.magFilter);
+	visit(a.mipFilter, b.mipFilter);
+	visit(a.addressU, b.addressU);
+	visit(a.addressV, b.addressV);
+	visit(a.addressW, b.addressW);
+	visit(a.reductionType, b.reductionType);
+}
+
+template<typename Visit>
+static void visit_stencil_op(
+	Visit& visit,
+	const nvrhi::DepthStencilState::StencilOpDesc& a,
+	const nvrhi::DepthStencilState::StencilOpDesc& b
+) {
+	visit(a.failOp, b.failOp);
+	visit(a.depthFailOp, b.depthFailOp);
+	visit(a.passOp, b.passOp);
+	visit(a.stencilFunc, b.stencilFunc);
+}
+
+template<typename Visit>
+static void visit_render_state(Visit& visit, const nvrhi::RenderState& a, const nvrhi::RenderState& b) {
+	visit(a.blendState.alphaToCoverageEnable, b.blendState.alphaToCoverageEnable);
+
+	for (usize i = 0; i < std::size(a.blendState.targets); i++) {
+		const auto& x = a.blendState.targets[i];
+		const auto& y = b.blendState.targets[i];
+
+		visit(x.blendEnable, y.blendEnable);
+		visit(x.srcBlend, y.srcBlend);
+		visit(x.destBlend, y.destBlend);
+		visit(x.blendOp, y.blendOp);
+		visit(x.srcBlendAlpha, y.srcBlendAlpha);
+		visit(x.destBlendAlpha, y.destBlendAlpha);
+		visit(x.blendOpAlpha, y.blendOpAlpha);
+		visit(x.colorWriteMask, y.colorWriteMask);
+	}
+
+	const auto& a_depth = a.depthStencilState;
+	const auto& b_depth = b.depthStencilState;
+	visit(a_depth.depthTestEnable, b_depth.depthTestEnable);
+	visit(a_depth.depthWriteEnable, b_depth.depthWriteEnable);
+	visit(a_depth.depthFunc, b_depth.depthFunc);
+	visit(a_depth.stencilEnable, b_depth.stencilEnable);
+	visit(a_depth.stencilReadMask, b_depth.stencilReadMask);
+	visit(a_depth.stencilWriteMask, b_depth.stencilWriteMask);
+	visit(a_depth.stencilRefValue, b_depth.stencilRefValue);
+	visit(a_depth.dynamicStencilRef, b_depth.dynamicStencilRef);
+	visit_stencil_op(visit, a_depth.frontFaceStencil, b_depth.frontFaceStencil);
+	visit_stencil_op(visit, a_depth.backFaceStencil, b_depth.backFaceStencil);
+
+	const auto& a_raster = a.rasterState;
+	const auto& b_raster = b.rasterState;
+	visit(a_raster.fillMode, b_raster.fillMode);
+	visit(a_raster.cullMode, b_raster.cullMode);
+	visit(a_raster.frontCounterClockwise, b_raster.frontCounterClockwise);
+	visit(a_raster.depthClipEnable, b_raster.depthClipEnable);
+	visit(a_raster.scissorEnable, b_raster.scissorEnable);
+	visit(a_raster.multisampleEnable, b_raster.multisampleEnable);
+	visit(a_raster.antialiasedLineEnable, b_raster.antialiasedLineEnable);
+	visit(a_raster.depthBias, b_raster.depthBias);
+	visit(a_raster.depthBiasClamp, b_raster.depthBiasClamp);
+	visit(a_raster.slopeScaledDepthBias, b_raster.slopeScaledDepthBias);
+	visit(a_raster.forcedSampleCount, b_raster.forcedSampleCount);
+	visit(a_raster.programmableSamplePositionsEnable, b_raster.programmableSamplePositionsEnable);
+	visit(a_raster.conservativeRasterEnable, b_raster.conservativeRasterEnable);
+	visit(a_raster.quadFillEnable, b_raster.quadFillEnable);
+
+	for (usize i = 0; i < std::size(a_raster.samplePositionsX); i++) {
+		visit(a_raster.samplePositionsX[i], b_raster.samplePositionsX[i]);
+		visit(a_raster.samplePositionsY[i], b_raster.samplePositionsY[i]);
+	}
+
+	const auto& a_shading_rate = a.shadingRateState;
+	const auto& b_shading_rate = b.shadingRateState;
+	visit(a_shading_rate.enabled, b_shading_rate.enabled);
+	visit(a_shading_rate.shadingRate, b_shading_rate.shadingRate);
+	visit(a_shading_rate.pipelinePrimitiveCombiner, b_shading_rate.pipelinePrimitiveCombiner);
+	visit(a_shading_rate.imageCombiner, b_shading_rate.imageCombiner);
+}
+
+template<typename Visit>
+static void visit_framebuffer_info(Visit& visit, const nvrhi::FramebufferInfo& a, const nvrhi::FramebufferInfo& b) {
+	visit_list(visit, a.colorFormats, b.colorFormats, [&](const nvrhi::Format x, const nvrhi::Format y) {
+		visit(x, y);
+	});
+
+	visit(a.depthFormat, b.depthFormat);
+	visit(a.sampleCount, b.sampleCount);
+	visit(a.sampleQuality, b.sampleQuality);
+}
+
+template<typename Visit, typename List>
+static void visit_binding_layouts(Visit& visit, const List& a, const List& b) {
+	visit_list(visit, a, b, [&](const nvrhi::BindingLayoutHandle& x, const nvrhi::BindingLayoutHandle& y) {
+		visit(static_cast<nvrhi::IBindingLayout*>(x), static_cast<nvrhi::IBindingLayout*>(y));
+	});
+}
+
+template<typename Visit>
+static void visit_shader(Visit& visit, const nvrhi::ShaderHandle& a, const nvrhi::ShaderHandle& b) {
+	visit(static_cast<nvrhi::IShader*>(a), static_cast<nvrhi::IShader*>(b));
+}
+
+template<typename Visit>
+static void visit_fields(
+	Visit& visit,
+	const nvrhi::GraphicsPipelineDesc& a,
+	const nvrhi::FramebufferInfo& a_framebuffer_info,
+	const nvrhi::GraphicsPipelineDesc& b,
+	const nvrhi::FramebufferInfo& b_framebuffer_info
+) {
+	visit(a.primType, b.primType);
+	visit(a.patchControlPoints, b.patchControlPoints);
+	visit(static_cast<nvrhi::IInputLayout*>(a.inputLayout), static_cast<nvrhi::IInputLayout*>(b.inputLayout));
+	visit_shader(visit, a.VS, b.VS);
+	visit_shader(visit, a.HS, b.HS);
+	visit_shader(visit, a.DS, b.DS);
+	visit_shader(visit, a.GS, b.GS);
+	visit_shader(visit, a.PS, b.PS);
+
+	visit_render_state(visit, a.renderState, b.renderState);
+	visit_binding_layouts(visit, a.bindingLayouts, b.bindingLayouts);
+	visit_framebuffer_info(visit, a_framebuffer_info, b_framebuffer_info);
+}
+
+template<typename Visit>
+static void visit_fields(
+	Visit& visit,
+	const nvrhi::MeshletPipelineDesc& a,
+	const nvrhi::FramebufferInfo& a_framebuffer_info,
+	const nvrhi::MeshletPipelineDesc& b,
+	const nvrhi::FramebufferInfo& b_framebuffer_info
+) {
+	visit(a.primType, b.primType);
+	visit_shader(visit, a.AS, b.AS);
+	visit_shader(visit, a.MS, b.MS);
+	visit_shader(visit, a.PS, b.PS);
+
+	visit_render_state(visit, a.renderState, b.renderState);
+	visit_binding_layouts(visit, a.bindingLayouts, b.bindingLayouts);
+	visit_framebuffer_info(visit, a_framebuffer_info, b_framebuffer_info);
+}
+
+template<typename Visit>
+static void visit_fields(Visit& visit, const nvrhi::ComputePipelineDesc& a, const nvrhi::ComputePipelineDesc& b) {
+	visit_shader(visit, a.CS, b.CS);
+	visit_binding_layouts(visit, a.bindingLayouts, b.bindingLayouts);
+}
+
+template<typename... Fields>
+static u64 hash_fields(const Fields&... fields) {
+	Hasher hasher;
+	visit_fields(hasher, fields..., fields...);
+	return hasher.seed;
+}
+
+// takes the fields of the first descriptor followed by the fields of the second
+template<typename... Fields>
+static bool equal_fields(const Fields&... fields) {
+	Comparer comparer;
+	visit_fields(comparer, fields...);
+	return comparer.equal;
+}
+
+// NOTE: objects are created outside the lock so slow pipeline compiles on different threads overlap,
+// when two threads race on the same key the first one to finish is kept.
+// a different descriptor that collides with a cached one is created and returned without being cached
+template<typename Entry, typename Equal, typename Create>
+static auto intern(
+	std::mutex& mutex,
+	std::unordered_map<u64, Entry>& cache,
+	CacheStats& stats,
+	const u64 key,
+	Equal&& equal,
+	Create&& create
+) -> decltype(Entry::handle) {
+	{
+		std::lock_guard lock(mutex);
+
+		if (const auto it = cache.find(key); it != cache.end() && equal(it->second)) {
+			stats.hits++;
+			return it->second.handle;
+		}
+
+		stats.misses++;
+	}
+
+	Entry entry = create();
+	if (!entry.handle)
+		return nullptr;
+
+	std::lock_guard lock(mutex);
+
+	const auto [it, inserted] = cache.try_emplace(key, entry);
+	return inserted || equal(it->second) ? it->second.handle : entry.handle;
+}
+
+PipelineCache::PipelineCache(nvrhi::DeviceHandle device, const usize binding_set_capacity) :
+	m_device(std::move(device)), m_binding_set_capacity(binding_set_capacity) {}
+
+nvrhi::InputLayoutHandle PipelineCache::get_input_layout(
+	std::span<const nvrhi::VertexAttributeDesc> attributes,
+	nvrhi::IShader* vertex_shader
+) {
+	const u64 key = hash_fields(attributes, vertex_shader);
+
+	const auto equal = [&](const InputLayoutEntry& entry) {
+		return equal_fields(std::span(entry.attributes), entry.vertex_shader.Get(), attributes, vertex_shader);
+	};
+
+	return intern(m_mutex, m_input_layouts, stats(CacheType::InputLayout), key, equal, [&] {
+		return InputLayoutEntry {
+			{attributes.begin(), attributes.end()},
+			nvrhi::ShaderHandle(vertex_shader),
+			m_device->createInputLayout(attributes.data(), static_cast<u32>(attributes.size()), vertex_shader),
+		};
+	});
+}
+
+nvrhi::BindingLayoutHandle PipelineCache::get_binding_layout(const nvrhi::BindingLayoutDesc& desc) {
+	const auto equal = [&](const BindingLayoutEntry& entry) {
+		return equal_fields(entry.desc, desc);
+	};
+
+	return intern(m_mutex, m_binding_layouts, stats(CacheType::BindingLayout), hash_fields(desc), equal, [&] {
+		return BindingLayoutEntry {desc, m_device->createBindingLayout(desc)};
+	});
+}
+
+nvrhi::SamplerHandle PipelineCache::get_sampler(const nvrhi::SamplerDesc& desc) {
+	const auto equal = [&](const SamplerEntry& entry) {
+		return equal_fields(entry.desc, desc);
+	};
+
+	return intern(m_mutex, m_samplers, stats(CacheType::Sampler), hash_fields(desc), equal, [&] {
+		return SamplerEntry {desc, m_device->createSampler(desc)};
+	});
+}
+
+nvrhi::BindingSetHandle PipelineCache::get_binding_set(const nvrhi::BindingSetDesc& desc, nvrhi::IBindingLayout* layout) {
+	usize key = 0;
+	nvrhi::hash_combine(key, desc);
+	nvrhi::hash_combine(key, layout);
+
+	// binding sets are cheap to create, holding the lock keeps the lru simple
+	std::lock_guard lock(m_mutex);
+
+	const auto it = m_binding_sets.find(key);
+	if (it != m_binding_sets.end() && it->second->desc == desc && it->second->layout == layout) {
+		stats(CacheType::BindingSet).hits++;
+		m_binding_set_lru.splice(m_binding_set_lru.begin(), m_binding_set_lru, it->second);
+		return it->second->handle;
+	}
+
+	stats(CacheType::BindingSet).misses++;
+
+	auto binding_set = m_device->createBindingSet(desc, layout);
+	if (!binding_set || it != m_binding_sets.end())
+		return binding_set;
+
+	m_binding_set_lru.push_front({key, desc, nvrhi::BindingLayoutHandle(layout), binding_set});
+	m_binding_sets.emplace(key, m_binding_set_lru.begin());
+
+	// NOTE: evicted sets stay alive as long as someone still holds a handle
+	while (m_binding_sets.size() > m_binding_set_capacity) {
+		erase_binding_set(std::prev(m_binding_set_lru.end()));
+	}
+
+	return binding_set;
+}
+
+nvrhi::GraphicsPipelineHandle PipelineCache::get_graphics_pipeline(
+	const nvrhi::GraphicsPipelineDesc& desc,
+	const nvrhi::FramebufferInfo& framebuffer_info
+) {
+	const u64 key = hash_fields(desc, framebuffer_info);
+
+	const auto equal = [&](const GraphicsPipelineEntry& entry) {
+		return equal_fields(entry.desc, entry.framebuffer_info, desc, framebuffer_info);
+	};
+
+	return intern(m_mutex, m_graphics_pipelines, stats(CacheType::GraphicsPipeline), key, equal, [&] {
+		return GraphicsPipelineEntry {desc, framebuffer_info, m_device->createGraphicsPipeline(desc, framebuffer_info)};
+	});
+}
+
+nvrhi::MeshletPipelineHandle PipelineCache::get_meshlet_pipeline(
+	const nvrhi::MeshletPipelineDesc& desc,
+	const nvrhi::FramebufferInfo& framebuffer_info
+) {
+	const u64 key = hash_fields(desc, framebuffer_info);
+
+	const auto equal = [&](const MeshletPipelineEntry& entry) {
+		return equal_fields(entry.desc, entry.framebuffer_info, desc, framebuffer_info);
+	};
+
+	return intern(m_mutex, m_meshlet_pipelines, stats(CacheType::MeshletPipeline), key, equal, [&] {
+		return MeshletPipelineEntry {desc, framebuffer_info, m_device->createMeshletPipeline(desc, framebuffer_info)};
+	});
+}
+
+nvrhi::ComputePipelineHandle PipelineCache::get_compute_pipeline(const nvrhi::ComputePipelineDesc& desc) {
+	const auto equal = [&](const ComputePipelineEntry& entry) {
+		return equal_fields(entry.desc, desc);
+	};
+
+	return intern(m_mutex, m_compute_pipelines, stats(CacheType::ComputePipeline), hash_fields(desc), equal, [&] {
+		return ComputePipelineEntry {desc, m_device->createComputePipeline(desc)};
+	});
+}
+
+void PipelineCache::invalidate(nvrhi::IResource* resource) {
+	std::lock_guard lock(m_mutex);
+
+	for (auto it = m_binding_set_lru.begin(); it != m_binding_set_lru.end();) {
+		const bool references = std::ranges::any_of(it->desc.bindings, [&](const nvrhi::BindingSetItem& item) {
+			return item.resourceHandle == resource;
+		});
+
+		it = references ? erase_binding_set(it) : std::next(it);
+	}
+}
+
+void PipelineCache::collect() {
+	std::lock_guard lock(m_mutex);
+
+	for (auto it = m_binding_set_lru.begin(); it != m_binding_set_lru.end();) {
+		// if we hold the only reference nothing can bind the set anymore, in-flight command lists hold one too
+		it->handle->AddRef();
+		it = it->handle->Release() > 1 ? std::next(it) : erase_binding_set(it);
+	}
+}
+
+CacheStats PipelineCache::get_stats(const CacheType type) const {
+	std::lock_guard lock(m_mutex);
+	return m_stats[static_cast<usize>(type)];
+}
+
+PipelineCache::BindingSetList::iterator PipelineCache::erase_binding_set(const BindingSetList::iterator it) {
+	m_binding_sets.erase(it->key);
+	stats(CacheType::BindingSet).evictions++;
+	return m_binding_set_lru.erase(it);
+}
+
+} // namespace vg::gfx
@@ -1,68 +1,62 @@
+#include <algorithm>
+#include <format>
 #include <print>
 
 #include "backends/dx12/device.hpp"
 #include "gfx/device.hpp"
+#include "metrics.hpp"
 
 namespace vg::gfx {
 
-std::unique_ptr<IDevice> IDevice::create() {
-	return std::make_unique<DX12Device>();
+std::unique_ptr<IDevice> IDevice::create(const DeviceOptions& options) {
+	return std::make_unique<DX12Device>(options);
 }
 
-void IDevice::message(const nvrhi::MessageSeverity severity, const char* text) {
-	std::string_view level;
-
+static std::string_view severity_name(const nvrhi::MessageSeverity severity) {
 	switch (severity) {
 		case nvrhi::MessageSeverity::Info:
-			level = "Info";
-			break;
+			return "Info";
 		case nvrhi::MessageSeverity::Warning:
-			level = "Warning";
-			break;
+			return "Warning";
 		case nvrhi::MessageSeverity::Error:
-			level = "Error";
-			break;
+			return "Error";
 		default:
-			level = "Unknown";
-			break;
+			return "Unknown";
 	}
+}
+
+IDevice::IDevice() {
+	for (usize i = 0; i < m_message_counters.size(); i++) {
+		const std::string_view level = severity_name(static_cast<nvrhi::MessageSeverity>(i));
+		m_message_counters[i] =
+			&MetricsRegistry::global().counter("device_messages", std::format("source=nvrhi,severity={}", level));
+	}
+}
+
+void IDevice::message(const nvrhi::MessageSeverity severity, const char* text) {
+	std::println("[nvrhi][{}]: {}", severity_name(severity), text);
 
-	std::println("[nvrhi][{}]: {}", level, text);
+	const usize index = std::min(static_cast<usize>(severity), m_message_counters.size() - 1);
+	m_message_counters[index]->add();
 }
 
 nvrhi::FramebufferHandle IDevice::begin_frame() {
 	acquire_frame();
+
+	// NOTE: sets first, the resources they held can then be freed in the same update
+	m_cache->collect();
+	m_memory->update(m_frame_index);
 	return m_framebuffers[get_current_index()];
 }
 
 void IDevice::end_frame() {
 	present_frame();
-}
-
-void IDevice::create_depth_buffer(const u32 width, const u32 height) {
-	m_depth_texture.Reset();
-
-	nvrhi::TextureDesc desc = {};
-	desc.setDebugName("depth_buffer");
-	desc.setWidth(width);
-	desc.setHeight(height);
-	desc.setFormat(nvrhi::Format::D32);
-	desc.setDimension(nvrhi::TextureDimension::Texture2D);
-	desc.setSampleCount(1);
-	desc.setSampleQuality(0);
-	desc.setIsTypeless(true);
-	desc.setIsRenderTarget(true);
-	desc.enableAutomaticStateTracking(nvrhi::ResourceStates::DepthWrite);
-	desc.setUseClearValue(true);
-	desc.setClearValue(nvrhi::Color(1, 0, 0, 0));
-
-	m_depth_texture = get_device()->createTexture(desc);
+	get_device()->runGarbageCollection();
+	m_frame_index++;
 }
 
 void IDevice::create_framebuffers() {
-	const auto tex_desc = get_buffer(0)->getDesc();
-	create_depth_buffer(tex_desc.width, tex_desc.height);
-
+	// NOTE: no depth attachment, the scene is drawn into the post process targets which own the depth buffer
 	// TODO: signal render passes
 
 	const u32 count = get_buffer_count();
@@ -71,7 +65,6 @@ void IDevice::create_framebuffers() {
 	for (u32 i = 0; i < count; i++) {
 		nvrhi::FramebufferDesc desc = {};
 		desc.addColorAttachment(get_buffer(i));
-		desc.setDepthAttachment(m_depth_texture);
 		m_framebuffers[i] = get_device()->createFramebuffer(desc);
 	}
 }
@@ -81,4 +74,10 @@ void IDevice::destroy_framebuffers() {
 	// TODO: signal render passes
 }
 
+void IDevice::destroy_resources() {
+	destroy_framebuffers();
+	m_cache.reset();
+	m_memory.reset();
+}
+
 } // namespace vg::gfx
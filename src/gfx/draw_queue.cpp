@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <bit>
+
+#include "gfx/draw_queue.hpp"
+
+namespace vg::gfx {
+
+static constexpr u32 DEPTH_BITS = 27;
+static constexpr u64 DEPTH_MASK = (u64(1) << DEPTH_BITS) - 1;
+
+static u64 quantize_depth(const f32 depth) {
+	// NOTE: non-negative floats keep their order when compared as integers, drop the low mantissa bits
+	const u32 bits = std::bit_cast<u32>(std::max(depth, 0.f));
+	return (bits >> (31 - DEPTH_BITS)) & DEPTH_MASK;
+}
+
+static bool needs_state(const DrawItem& prev, const DrawItem& next) {
+	return prev.pipeline != next.pipeline || prev.binding_sets != next.binding_sets
+		|| prev.vertex_buffer != next.vertex_buffer || prev.index_buffer != next.index_buffer
+		|| prev.index_format != next.index_format || prev.indirect_buffer != next.indirect_buffer;
+}
+
+DrawQueue::DrawQueue(ThreadPool* thread_pool) : m_sort(thread_pool) {}
+
+void DrawQueue::begin(nvrhi::IFramebuffer* framebuffer, const nvrhi::ViewportState& viewport) {
+	m_framebuffer = framebuffer;
+	m_viewport = viewport;
+	m_stats = {};
+
+	m_items.clear();
+	m_entries.clear();
+
+	// ids only need to be stable while they group the draws of one queue
+	m_pipeline_ids.clear();
+	m_material_ids.clear();
+}
+
+void DrawQueue::submit(const DrawItem& item, const DrawLayer layer, const bool translucent, const f32 depth) {
+	const u64 pipeline = get_id(m_pipeline_ids, item.pipeline);
+	const u64 material = get_id(m_material_ids, item.binding_sets[0]);
+	const u64 quantized = quantize_depth(depth);
+
+	u64 key = static_cast<u64>(layer) << 60;
+
+	if (translucent) {
+		key |= u64(1) << 59;
+		key |= (~quantized & DEPTH_MASK) << 32;
+		key |= pipeline << 16;
+		key |= material;
+	} else {
+		key |= pipeline << 43;
+		key |= material << DEPTH_BITS;
+		key |= quantized;
+	}
+
+	m_entries.push_back({key, static_cast<u32>(m_items.size())});
+	m_items.push_back(item);
+}
+
+void DrawQueue::flush(nvrhi::ICommandList* command_list) {
+	m_sort.sort(m_entries);
+
+	const DrawItem* prev = nullptr;
+
+	for (const auto& entry : m_entries) {
+		const DrawItem& item = m_items[entry.index];
+
+		if (prev == nullptr || needs_state(*prev, item)) {
+			nvrhi::GraphicsState state;
+			state.setPipeline(item.pipeline);
+			state.setFramebuffer(m_framebuffer);
+			state.setViewport(m_viewport);
+
+			for (nvrhi::IBindingSet* binding_set : item.binding_sets) {
+				if (binding_set != nullptr)
+					state.addBindingSet(binding_set);
+			}
+
+			if (item.vertex_buffer != nullptr)
+				state.addVertexBuffer(nvrhi::VertexBufferBinding().setBuffer(item.vertex_buffer).setSlot(0));
+			if (item.index_buffer != nullptr)
+				state.setIndexBuffer(nvrhi::IndexBufferBinding().setBuffer(item.index_buffer).setFormat(item.index_format));
+			if (item.indirect_buffer != nullptr)
+				state.setIndirectParams(item.indirect_buffer);
+
+			command_list->setGraphicsState(state);
+			m_stats.state_changes++;
+		} else {
+			m_stats.state_changes_skipped++;
+		}
+
+		if (item.push_constants_size > 0)
+			command_list->setPushConstants(item.push_constants.data(), item.push_constants_size);
+
+		if (item.indirect_buffer != nullptr && item.index_buffer != nullptr)
+			command_list->drawIndexedIndirect(item.indirect_offset, item.indirect_count);
+		else if (item.indirect_buffer != nullptr)
+			command_list->drawIndirect(item.indirect_offset, item.indirect_count);
+		else if (item.index_buffer != nullptr)
+			command_list->drawIndexed(item.args);
+		else
+			command_list->draw(item.args);
+
+		m_stats.draws++;
+		prev = &item;
+	}
+
+	m_items.clear();
+	m_entries.clear();
+}
+
+u16 DrawQueue::get_id(std::unordered_map<const void*, u16>& ids, const void* object) {
+	if (const auto it = ids.find(object); it != ids.end())
+		return it->second;
+
+	// NOTE: past 65536 distinct objects in one queue ids wrap around, which only weakens the grouping
+	const auto id = static_cast<u16>(ids.size());
+	ids.emplace(object, id);
+	return id;
+}
+
+} // namespace vg::gfx
@@ -0,0 +1,199 @@
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "gfx/lighting.hpp"
+
+namespace vg::gfx {
+
+// NOTE: must match the OVERFLOW_ defines in shaders/lighting.hlsli
+enum class LightOverflow : u32 {
+	Clusters,
+	Lights,
+	Count,
+};
+
+static constexpr u32 OVERFLOW_BYTES = static_cast<u32>(LightOverflow::Count) * sizeof(u32);
+
+// NOTE: must match the ClusterParams cbuffer in shaders/lighting.hlsli
+struct ClusterParams {
+	glm::mat4 view;
+	glm::mat4 inv_projection;
+	glm::vec4 camera_position;
+	glm::uvec4 grid; // cluster counts, light count
+	glm::vec4 screen; // size, inverse size
+	glm::vec4 depth; // near, far, slice scale, slice bias
+};
+
+ClusteredLighting::ClusteredLighting(IDevice& device, nvrhi::ShaderHandle binning_shader) :
+	m_device(device.get_device()),
+	m_upload_bytes(MetricsRegistry::global().counter("upload_bytes")) {
+	auto& memory = device.get_memory();
+	auto& cache = device.get_cache();
+
+	nvrhi::BufferDesc params_desc = {};
+	params_desc.setByteSize(sizeof(ClusterParams));
+	params_desc.setIsConstantBuffer(true);
+	params_desc.setIsVolatile(true);
+	params_desc.setMaxVersions(16);
+	params_desc.setDebugName("cluster_params");
+
+	m_params_buffer = memory.create_buffer(params_desc, MemoryCategory::Constant);
+
+	nvrhi::BufferDesc light_desc = {};
+	light_desc.setByteSize(MAX_LIGHTS * sizeof(Light));
+	light_desc.setStructStride(sizeof(Light));
+	light_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	light_desc.setDebugName("light_buffer");
+
+	m_light_buffer = memory.create_buffer(light_desc, MemoryCategory::Streamed);
+
+	nvrhi::BufferDesc cluster_desc = {};
+	cluster_desc.setByteSize(CLUSTER_COUNT * sizeof(u32));
+	cluster_desc.setStructStride(sizeof(u32));
+	cluster_desc.setCanHaveUAVs(true);
+	cluster_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	cluster_desc.setDebugName("cluster_buffer");
+
+	m_cluster_buffer = memory.create_buffer(cluster_desc, MemoryCategory::Scratch);
+
+	nvrhi::BufferDesc index_desc = {};
+	index_desc.setByteSize(CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(u32));
+	index_desc.setStructStride(sizeof(u32));
+	index_desc.setCanHaveUAVs(true);
+	index_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	index_desc.setDebugName("cluster_light_indices");
+
+	m_index_buffer = memory.create_buffer(index_desc, MemoryCategory::Scratch);
+
+	nvrhi::BufferDesc overflow_desc = {};
+	overflow_desc.setByteSize(OVERFLOW_BYTES);
+	overflow_desc.setStructStride(sizeof(u32));
+	overflow_desc.setCanHaveUAVs(true);
+	overflow_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::UnorderedAccess);
+	overflow_desc.setDebugName("cluster_overflow");
+
+	m_overflow_buffer = memory.create_buffer(overflow_desc, MemoryCategory::Scratch);
+
+	for (auto& readback : m_readback) {
+		nvrhi::BufferDesc readback_desc = {};
+		readback_desc.setByteSize(OVERFLOW_BYTES);
+		readback_desc.setCpuAccess(nvrhi::CpuAccessMode::Read);
+		readback_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::CopyDest);
+		readback_desc.setDebugName("cluster_overflow_readback");
+
+		readback = memory.create_buffer(readback_desc, MemoryCategory::Streamed);
+	}
+
+	nvrhi::BindingLayoutDesc binning_layout_desc = {};
+	binning_layout_desc.setVisibility(nvrhi::ShaderType::Compute);
+	binning_layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0));
+	binning_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0));
+	binning_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(0));
+	binning_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(1));
+	binning_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(2));
+
+	auto binning_layout = cache.get_binding_layout(binning_layout_desc);
+
+	nvrhi::ComputePipelineDesc pipeline_desc = {};
+	pipeline_desc.setComputeShader(binning_shader);
+	pipeline_desc.addBindingLayout(binning_layout);
+
+	m_binning_pipeline = cache.get_compute_pipeline(pipeline_desc);
+
+	nvrhi::BindingSetDesc binning_set_desc = {};
+	binning_set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_params_buffer));
+	binning_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_light_buffer));
+	binning_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(0, m_cluster_buffer));
+	binning_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(1, m_index_buffer));
+	binning_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(2, m_overflow_buffer));
+
+	m_binning_set = cache.get_binding_set(binning_set_desc, binning_layout);
+
+	// NOTE: shading resources live in space1 so they can sit next to the material bindings
+	nvrhi::BindingLayoutDesc layout_desc = {};
+	layout_desc.setVisibility(nvrhi::ShaderType::Pixel);
+	layout_desc.setRegisterSpace(1);
+	layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(2));
+
+	m_binding_layout = cache.get_binding_layout(layout_desc);
+
+	nvrhi::BindingSetDesc set_desc = {};
+	set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_params_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_light_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, m_cluster_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(2, m_index_buffer));
+
+	m_binding_set = cache.get_binding_set(set_desc, m_binding_layout);
+}
+
+void ClusteredLighting::update(
+	nvrhi::ICommandList* command_list,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const f32 near_plane,
+	const f32 far_plane,
+	const u32 width,
+	const u32 height,
+	std::span<const Light> lights
+) {
+	const auto light_count = static_cast<u32>(std::min<usize>(lights.size(), MAX_LIGHTS));
+	m_stats.lights = light_count;
+	m_stats.dropped_lights = static_cast<u32>(lights.size() - light_count);
+
+	const f32 log_ratio = std::log(far_plane / near_plane);
+
+	ClusterParams params = {};
+	params.view = view;
+	params.inv_projection = glm::inverse(projection);
+	params.camera_position = glm::inverse(view)[3];
+	params.grid = glm::uvec4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, light_count);
+	params.screen = glm::vec4(width, height, 1.f / static_cast<f32>(width), 1.f / static_cast<f32>(height));
+	params.depth = glm::vec4(
+		near_plane,
+		far_plane,
+		static_cast<f32>(CLUSTER_Z) / log_ratio,
+		-static_cast<f32>(CLUSTER_Z) * std::log(near_plane) / log_ratio
+	);
+
+	command_list->writeBuffer(m_params_buffer, &params, sizeof(ClusterParams));
+
+	if (light_count > 0) {
+		command_list->writeBuffer(m_light_buffer, lights.data(), light_count * sizeof(Light));
+	}
+
+	m_upload_bytes.add(sizeof(ClusterParams) + light_count * sizeof(Light));
+
+	command_list->clearBufferUInt(m_overflow_buffer, 0);
+
+	nvrhi::ComputeState state;
+	state.setPipeline(m_binning_pipeline);
+	state.addBindingSet(m_binning_set);
+
+	command_list->setComputeState(state);
+	command_list->dispatch((CLUSTER_COUNT + GROUP_SIZE - 1) / GROUP_SIZE);
+
+	// same ring as the meshlet counters, mapping the oldest slot never waits on the gpu
+	command_list->copyBuffer(m_readback[m_frame % READBACK_LATENCY], 0, m_overflow_buffer, 0, OVERFLOW_BYTES);
+	m_frame++;
+
+	if (m_frame < READBACK_LATENCY)
+		return;
+
+	const u64 oldest = m_frame % READBACK_LATENCY;
+
+	const auto* overflow = static_cast<const u32*>(m_device->mapBuffer(m_readback[oldest], nvrhi::CpuAccessMode::Read));
+	if (overflow == nullptr)
+		return;
+
+	m_stats.full_clusters = overflow[static_cast<u32>(LightOverflow::Clusters)];
+	m_stats.dropped_cluster_lights = overflow[static_cast<u32>(LightOverflow::Lights)];
+
+	m_device->unmapBuffer(m_readback[oldest]);
+}
+
+} // namespace vg::gfx
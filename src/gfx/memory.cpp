@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+
+#include "gfx/device.hpp"
+#include "gfx/memory.hpp"
+
+namespace vg::gfx {
+
+static u64 align_up(const u64 value, const u64 alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+MemoryManager::MemoryManager(IDevice& device, const u64 heap_size) : m_device(device), m_heap_size(heap_size) {}
+
+MemoryManager::~MemoryManager() = default;
+
+nvrhi::BufferHandle MemoryManager::create_buffer(nvrhi::BufferDesc desc, const MemoryCategory category) {
+	const auto device = m_device.get_device();
+
+	// NOTE: volatile buffers have no backing memory, they are sub-allocated from the upload ring.
+	// they are still tracked, so their worst case ring usage shows up in the category stats
+	if (desc.isVolatile) {
+		auto buffer = device->createBuffer(desc);
+		if (!buffer)
+			throw std::runtime_error("Failed to create buffer");
+
+		TlsfAllocator::Allocation range = {};
+		range.size = desc.byteSize * desc.maxVersions;
+
+		std::lock_guard lock(m_mutex);
+		track(buffer, nullptr, range, category);
+		return buffer;
+	}
+
+	desc.isVirtual = true;
+
+	auto buffer = device->createBuffer(desc);
+	if (!buffer)
+		throw std::runtime_error("Failed to create buffer");
+
+	nvrhi::HeapType type = nvrhi::HeapType::DeviceLocal;
+	if (desc.cpuAccess == nvrhi::CpuAccessMode::Write)
+		type = nvrhi::HeapType::Upload;
+	else if (desc.cpuAccess == nvrhi::CpuAccessMode::Read)
+		type = nvrhi::HeapType::Readback;
+
+	std::lock_guard lock(m_mutex);
+
+	const auto requirements = device->getBufferMemoryRequirements(buffer);
+	const auto [heap, range] = allocate(type, HeapClass::Buffer, requirements);
+
+	if (!device->bindBufferMemory(buffer, heap->handle, range.offset)) {
+		heap->allocator.free(range);
+		throw std::runtime_error("Failed to bind buffer memory");
+	}
+
+	track(buffer, heap, range, category);
+	return buffer;
+}
+
+nvrhi::TextureHandle MemoryManager::create_texture(nvrhi::TextureDesc desc, const MemoryCategory category) {
+	const auto device = m_device.get_device();
+
+	desc.isVirtual = true;
+
+	auto texture = device->createTexture(desc);
+	if (!texture)
+		throw std::runtime_error("Failed to create texture");
+
+	// NOTE: resource heap tier 1 cannot mix render targets with other textures
+	const HeapClass heap_class = desc.isRenderTarget ? HeapClass::RenderTarget : HeapClass::Texture;
+
+	std::lock_guard lock(m_mutex);
+
+	const auto requirements = device->getTextureMemoryRequirements(texture);
+	const auto [heap, range] = allocate(nvrhi::HeapType::DeviceLocal, heap_class, requirements);
+
+	if (!device->bindTextureMemory(texture, heap->handle, range.offset)) {
+		heap->allocator.free(range);
+		throw std::runtime_error("Failed to bind texture memory");
+	}
+
+	track(texture, heap, range, category);
+	return texture;
+}
+
+void MemoryManager::set_eviction_callback(nvrhi::IResource* resource, std::function<void()> callback) {
+	std::lock_guard lock(m_mutex);
+
+	const auto it = m_allocations.find(resource);
+	if (it == m_allocations.end())
+		return;
+
+	if (it->second.category != MemoryCategory::Streamed)
+		throw std::runtime_error("Only streamed resources can be evicted");
+
+	it->second.evict = std::move(callback);
+}
+
+void MemoryManager::touch(nvrhi::IResource* resource) {
+	std::lock_guard lock(m_mutex);
+
+	if (const auto it = m_allocations.find(resource); it != m_allocations.end())
+		it->second.last_used = m_frame;
+}
+
+void MemoryManager::update(const u64 frame) {
+	std::lock_guard lock(m_mutex);
+
+	m_frame = frame;
+
+	collect();
+
+	m_stats.budget = m_device.query_memory_budget();
+
+	const auto budget = static_cast<f64>(m_stats.budget.budget);
+	const auto usage = static_cast<f64>(m_stats.budget.usage);
+
+	// NOTE: evicted resources keep counting towards the usage until their owners let go of them
+	const f64 excess = usage - budget * EVICTION_TARGET - static_cast<f64>(m_evicting_bytes);
+
+	if (budget > 0 && usage > budget * EVICTION_THRESHOLD && excess > 0) {
+		evict(static_cast<u64>(excess));
+	}
+}
+
+MemoryStats MemoryManager::get_stats() const {
+	std::lock_guard lock(m_mutex);
+	return m_stats;
+}
+
+MemoryManager::Pool& MemoryManager::get_pool(const nvrhi::HeapType type, const HeapClass heap_class) {
+	const usize index = static_cast<usize>(type) * static_cast<usize>(HeapClass::Count) + static_cast<usize>(heap_class);
+	return m_pools[index];
+}
+
+std::pair<MemoryManager::Heap*, TlsfAllocator::Allocation> MemoryManager::allocate(
+	const nvrhi::HeapType type,
+	const HeapClass heap_class,
+	const nvrhi::MemoryRequirements& requirements
+) {
+	auto& pool = get_pool(type, heap_class);
+	const bool dedicated = requirements.size > m_heap_size;
+
+	if (!dedicated) {
+		for (const auto& heap : pool) {
+			if (heap->dedicated)
+				continue;
+
+			if (const auto range = heap->allocator.allocate(requirements.size, requirements.alignment))
+				return {heap.get(), *range};
+		}
+	}
+
+	const u64 capacity = dedicated ? align_up(requirements.size, HEAP_ALIGNMENT) : m_heap_size;
+
+	nvrhi::HeapDesc desc = {};
+	desc.capacity = capacity;
+	desc.type = type;
+	desc.debugName = std::format("heap_{}_{}", static_cast<u32>(type), static_cast<u32>(heap_class));
+
+	auto handle = m_device.get_device()->createHeap(desc);
+	if (!handle)
+		throw std::runtime_error("Failed to create heap");
+
+	auto& heap = pool.emplace_back(std::make_unique<Heap>(handle, TlsfAllocator(capacity, HEAP_ALIGNMENT), dedicated));
+
+	m_stats.heap_bytes += capacity;
+	m_stats.heap_count++;
+
+	const auto range = heap->allocator.allocate(requirements.size, requirements.alignment);
+	if (!range)
+		throw std::runtime_error("Failed to allocate from new heap");
+
+	return {heap.get(), *range};
+}
+
+void MemoryManager::track(
+	nvrhi::IResource* resource,
+	Heap* heap,
+	const TlsfAllocator::Allocation& range,
+	const MemoryCategory category
+) {
+	Allocation allocation = {};
+	allocation.resource = nvrhi::ResourceHandle(resource);
+	allocation.heap = heap;
+	allocation.range = range;
+	allocation.category = category;
+	allocation.last_used = m_frame;
+
+	m_allocations.emplace(resource, std::move(allocation));
+	m_stats.category_bytes[static_cast<usize>(category)] += range.size;
+
+	if (heap != nullptr) {
+		m_stats.allocated_bytes += range.size;
+		m_stats.allocation_count++;
+	}
+}
+
+void MemoryManager::collect() {
+	for (auto it = m_allocations.begin(); it != m_allocations.end();) {
+		auto& allocation = it->second;
+
+		// if we hold the only reference nothing can use the resource anymore
+		allocation.resource->AddRef();
+		if (allocation.resource->Release() > 1) {
+			++it;
+			continue;
+		}
+
+		m_stats.category_bytes[static_cast<usize>(allocation.category)] -= allocation.range.size;
+
+		if (allocation.heap != nullptr) {
+			m_stats.allocated_bytes -= allocation.range.size;
+			m_stats.allocation_count--;
+			m_pending_frees.push_back({allocation.heap, allocation.range, m_frame});
+		}
+
+		if (allocation.evicted) {
+			m_evicting_bytes -= allocation.range.size;
+			m_stats.evicted_bytes += allocation.range.size;
+			m_stats.evicted_count++;
+		}
+
+		it = m_allocations.erase(it);
+	}
+
+	// NOTE: wait for in-flight frames before the memory can be aliased by a new resource
+	const u64 latency = m_device.get_buffer_count() + 1;
+
+	std::erase_if(m_pending_frees, [&](const PendingFree& pending) {
+		if (m_frame < pending.frame + latency)
+			return false;
+
+		pending.heap->allocator.free(pending.range);
+		return true;
+	});
+
+	release_empty_heaps();
+}
+
+void MemoryManager::evict(const u64 bytes) {
+	const u64 latency = m_device.get_buffer_count() + 1;
+
+	std::vector<Allocation*> candidates;
+	for (auto& allocation : m_allocations | std::views::values) {
+		if (allocation.evict && allocation.last_used + latency < m_frame)
+			candidates.push_back(&allocation);
+	}
+
+	std::ranges::sort(candidates, {}, &Allocation::last_used);
+
+	// NOTE: nothing is freed here, the bytes only count as evicted once collect finds the resource unreferenced
+	u64 requested = 0;
+	for (Allocation* allocation : candidates) {
+		if (requested >= bytes)
+			break;
+
+		// NOTE: the callback may create a replacement resource, so take it out first
+		const auto callback = std::move(allocation->evict);
+		allocation->evict = nullptr;
+		allocation->evicted = true;
+
+		requested += allocation->range.size;
+		m_evicting_bytes += allocation->range.size;
+
+		// a cached binding set would keep the resource alive after its owner replaced it
+		m_device.get_cache().invalidate(allocation->resource);
+
+		callback();
+	}
+}
+
+void MemoryManager::release_empty_heaps() {
+	for (auto& pool : m_pools) {
+		bool keep_shared = true;
+
+		std::erase_if(pool, [&](const std::unique_ptr<Heap>& heap) {
+			if (!heap->allocator.is_empty())
+				return false;
+
+			// keep one shared heap around per pool to avoid churn
+			if (!heap->dedicated && keep_shared) {
+				keep_shared = false;
+				return false;
+			}
+
+			m_stats.heap_bytes -= heap->allocator.get_capacity();
+			m_stats.heap_count--;
+			return true;
+		});
+	}
+}
+
+} // namespace vg::gfx
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <vector>
+
+#include "gfx/meshlets.hpp"
+#include "scene/bounds.hpp"
+
+namespace vg::gfx {
+
+// NOTE: must match the MeshletCullParams struct in shaders/meshlet.hlsli
+struct MeshletCullParams {
+	std::array<glm::vec4, 6> planes;
+	glm::vec4 camera_position;
+	glm::uvec4 counts; // meshlets, instances
+};
+
+// NOTE: must match the COUNTER_ defines in shaders/meshlet.hlsli
+enum class MeshletCounter : u32 {
+	VisibleMeshlets,
+	VisibleTriangles,
+	Count,
+};
+
+static constexpr u32 COUNTER_BYTES = static_cast<u32>(MeshletCounter::Count) * sizeof(u32);
+
+MeshletMesh::MeshletMesh(
+	IDevice& device,
+	nvrhi::ShaderHandle cull_shader,
+	const scene::MeshletData& data,
+	const u32 vertex_count,
+	const u32 vertex_stride
+) :
+	m_meshlet_count(static_cast<u32>(data.meshlets.size())),
+	m_triangle_count(data.get_triangle_count()),
+	m_device(device.get_device()),
+	m_upload_bytes(MetricsRegistry::global().counter("upload_bytes")) {
+	auto& memory = device.get_memory();
+	auto& cache = device.get_cache();
+
+	// NOTE: the vertex buffer is also read as a structured buffer by the mesh shader
+	nvrhi::BufferDesc vertex_desc = {};
+	vertex_desc.setByteSize(static_cast<u64>(vertex_count) * vertex_stride);
+	vertex_desc.setStructStride(vertex_stride);
+	vertex_desc.setIsVertexBuffer(true);
+	vertex_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::VertexBuffer);
+	vertex_desc.setDebugName("meshlet_vertex_buffer");
+
+	m_vertex_buffer = memory.create_buffer(vertex_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc index_desc = {};
+	index_desc.setByteSize(data.indices.size() * sizeof(u32));
+	index_desc.setIsIndexBuffer(true);
+	index_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::IndexBuffer);
+	index_desc.setDebugName("meshlet_index_buffer");
+
+	m_index_buffer = memory.create_buffer(index_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc meshlet_desc = {};
+	meshlet_desc.setByteSize(m_meshlet_count * sizeof(GpuMeshlet));
+	meshlet_desc.setStructStride(sizeof(GpuMeshlet));
+	meshlet_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	meshlet_desc.setDebugName("meshlets");
+
+	m_meshlet_buffer = memory.create_buffer(meshlet_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc meshlet_vertex_desc = {};
+	meshlet_vertex_desc.setByteSize(data.vertices.size() * sizeof(u32));
+	meshlet_vertex_desc.setStructStride(sizeof(u32));
+	meshlet_vertex_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	meshlet_vertex_desc.setDebugName("meshlet_vertices");
+
+	m_meshlet_vertex_buffer = memory.create_buffer(meshlet_vertex_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc meshlet_triangle_desc = {};
+	meshlet_triangle_desc.setByteSize(data.triangles.size() * sizeof(u32));
+	meshlet_triangle_desc.setStructStride(sizeof(u32));
+	meshlet_triangle_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	meshlet_triangle_desc.setDebugName("meshlet_triangles");
+
+	m_meshlet_triangle_buffer = memory.create_buffer(meshlet_triangle_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc params_desc = {};
+	params_desc.setByteSize(sizeof(MeshletCullParams));
+	params_desc.setIsConstantBuffer(true);
+	params_desc.setIsVolatile(true);
+	params_desc.setMaxVersions(16);
+	params_desc.setDebugName("meshlet_cull_params");
+
+	m_params_buffer = memory.create_buffer(params_desc, MemoryCategory::Constant);
+
+	nvrhi::BufferDesc instance_desc = {};
+	instance_desc.setByteSize(MAX_INSTANCES * sizeof(glm::mat4));
+	instance_desc.setStructStride(sizeof(glm::mat4));
+	instance_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	instance_desc.setDebugName("meshlet_instances");
+
+	m_instance_buffer = memory.create_buffer(instance_desc, MemoryCategory::Geometry);
+
+	nvrhi::BufferDesc argument_desc = {};
+	argument_desc.setByteSize(MAX_INSTANCES * m_meshlet_count * sizeof(nvrhi::DrawIndexedIndirectArguments));
+	argument_desc.setStructStride(sizeof(nvrhi::DrawIndexedIndirectArguments));
+	argument_desc.setIsDrawIndirectArgs(true);
+	argument_desc.setCanHaveUAVs(true);
+	argument_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::IndirectArgument);
+	argument_desc.setDebugName("meshlet_draw_arguments");
+
+	m_argument_buffer = memory.create_buffer(argument_desc, MemoryCategory::Scratch);
+
+	nvrhi::BufferDesc counter_desc = {};
+	counter_desc.setByteSize(COUNTER_BYTES);
+	counter_desc.setStructStride(sizeof(u32));
+	counter_desc.setCanHaveUAVs(true);
+	counter_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::UnorderedAccess);
+	counter_desc.setDebugName("meshlet_counters");
+
+	m_counter_buffer = memory.create_buffer(counter_desc, MemoryCategory::Scratch);
+
+	// counters are copied into a ring so reading them back never waits on the frame that wrote them
+	for (auto& readback : m_readback) {
+		nvrhi::BufferDesc readback_desc = {};
+		readback_desc.setByteSize(COUNTER_BYTES);
+		readback_desc.setCpuAccess(nvrhi::CpuAccessMode::Read);
+		readback_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::CopyDest);
+		readback_desc.setDebugName("meshlet_counter_readback");
+
+		readback = memory.create_buffer(readback_desc, MemoryCategory::Streamed);
+	}
+
+	nvrhi::BindingLayoutDesc cull_layout_desc = {};
+	cull_layout_desc.setVisibility(nvrhi::ShaderType::Compute);
+	cull_layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0));
+	cull_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0));
+	cull_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1));
+	cull_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(0));
+	cull_layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(1));
+
+	auto cull_layout = cache.get_binding_layout(cull_layout_desc);
+
+	nvrhi::ComputePipelineDesc pipeline_desc = {};
+	pipeline_desc.setComputeShader(cull_shader);
+	pipeline_desc.addBindingLayout(cull_layout);
+
+	m_cull_pipeline = cache.get_compute_pipeline(pipeline_desc);
+
+	nvrhi::BindingSetDesc cull_set_desc = {};
+	cull_set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_params_buffer));
+	cull_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_meshlet_buffer));
+	cull_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, m_instance_buffer));
+	cull_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(0, m_argument_buffer));
+	cull_set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(1, m_counter_buffer));
+
+	m_cull_set = cache.get_binding_set(cull_set_desc, cull_layout);
+
+	if (!supports_mesh_shaders(device))
+		return;
+
+	// NOTE: mesh shader resources live in space2, next to the material (space0) and lighting (space1) bindings
+	nvrhi::BindingLayoutDesc layout_desc = {};
+	layout_desc.setVisibility(nvrhi::ShaderType::Amplification | nvrhi::ShaderType::Mesh);
+	layout_desc.setRegisterSpace(2);
+	layout_desc.addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(0));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(1));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(2));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(3));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_UAV(0));
+
+	m_binding_layout = cache.get_binding_layout(layout_desc);
+
+	nvrhi::BindingSetDesc set_desc = {};
+	set_desc.addItem(nvrhi::BindingSetItem::ConstantBuffer(0, m_params_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_meshlet_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(1, m_meshlet_vertex_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(2, m_meshlet_triangle_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(3, m_vertex_buffer));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_UAV(0, m_counter_buffer));
+
+	m_binding_set = cache.get_binding_set(set_desc, m_binding_layout);
+}
+
+bool MeshletMesh::supports_mesh_shaders(IDevice& device) {
+	return device.get_device()->queryFeatureSupport(nvrhi::Feature::Meshlets);
+}
+
+void MeshletMesh::upload(
+	nvrhi::ICommandList* command_list,
+	const scene::MeshletData& data,
+	std::span<const std::byte> vertices
+) {
+	std::vector<GpuMeshlet> meshlets;
+	meshlets.reserve(data.meshlets.size());
+
+	for (usize i = 0; i < data.meshlets.size(); i++) {
+		const auto& meshlet = data.meshlets[i];
+		const auto& bounds = data.bounds[i];
+
+		GpuMeshlet gpu_meshlet = {};
+		gpu_meshlet.sphere = glm::vec4(bounds.center, bounds.radius);
+		gpu_meshlet.cone_apex = glm::vec4(bounds.cone_apex, 0.f);
+		gpu_meshlet.cone_axis = glm::vec4(bounds.cone_axis, bounds.cone_cutoff);
+		gpu_meshlet.ranges = glm::uvec4(
+			meshlet.vertex_offset,
+			meshlet.triangle_offset,
+			meshlet.vertex_count,
+			meshlet.triangle_count
+		);
+		meshlets.push_back(gpu_meshlet);
+	}
+
+	command_list->writeBuffer(m_vertex_buffer, vertices.data(), vertices.size());
+	command_list->writeBuffer(m_index_buffer, data.indices.data(), data.indices.size() * sizeof(u32));
+	command_list->writeBuffer(m_meshlet_buffer, meshlets.data(), meshlets.size() * sizeof(GpuMeshlet));
+	command_list->writeBuffer(m_meshlet_vertex_buffer, data.vertices.data(), data.vertices.size() * sizeof(u32));
+	command_list->writeBuffer(m_meshlet_triangle_buffer, data.triangles.data(), data.triangles.size() * sizeof(u32));
+
+	m_upload_bytes.add(
+		vertices.size() + meshlets.size() * sizeof(GpuMeshlet)
+		+ (data.indices.size() + data.vertices.size() + data.triangles.size()) * sizeof(u32)
+	);
+}
+
+void MeshletMesh::update(
+	nvrhi::ICommandList* command_list,
+	const glm::mat4& view_projection,
+	const glm::vec3& camera_position,
+	std::span<const glm::mat4> instances
+) {
+	m_instance_count = static_cast<u32>(std::min<usize>(instances.size(), MAX_INSTANCES));
+
+	MeshletCullParams params = {};
+	params.planes = scene::Frustum::from_matrix(view_projection).planes;
+	params.camera_position = glm::vec4(camera_position, 1.f);
+	params.counts = glm::uvec4(m_meshlet_count, m_instance_count, 0, 0);
+
+	command_list->writeBuffer(m_params_buffer, &params, sizeof(MeshletCullParams));
+
+	if (m_instance_count > 0) {
+		command_list->writeBuffer(m_instance_buffer, instances.data(), m_instance_count * sizeof(glm::mat4));
+	}
+
+	m_upload_bytes.add(sizeof(MeshletCullParams) + m_instance_count * sizeof(glm::mat4));
+
+	command_list->clearBufferUInt(m_counter_buffer, 0);
+}
+
+void MeshletMesh::cull(nvrhi::ICommandList* command_list) {
+	if (m_instance_count == 0)
+		return;
+
+	nvrhi::ComputeState state;
+	state.setPipeline(m_cull_pipeline);
+	state.addBindingSet(m_cull_set);
+
+	command_list->setComputeState(state);
+	command_list->dispatch((m_meshlet_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, m_instance_count);
+}
+
+void MeshletMesh::resolve_stats(nvrhi::ICommandList* command_list) {
+	const u64 slot = m_frame % READBACK_LATENCY;
+
+	command_list->copyBuffer(m_readback[slot], 0, m_counter_buffer, 0, COUNTER_BYTES);
+	m_readback_instances[slot] = m_instance_count;
+	m_frame++;
+
+	if (m_frame < READBACK_LATENCY)
+		return;
+
+	// the oldest slot was submitted READBACK_LATENCY - 1 frames ago, by now mapping it doesn't stall
+	const u64 oldest = m_frame % READBACK_LATENCY;
+
+	const auto* counters = static_cast<const u32*>(m_device->mapBuffer(m_readback[oldest], nvrhi::CpuAccessMode::Read));
+	if (counters == nullptr)
+		return;
+
+	m_stats.meshlets = m_meshlet_count * m_readback_instances[oldest];
+	m_stats.triangles = m_triangle_count * m_readback_instances[oldest];
+	m_stats.visible_meshlets = counters[static_cast<u32>(MeshletCounter::VisibleMeshlets)];
+	m_stats.visible_triangles = counters[static_cast<u32>(MeshletCounter::VisibleTriangles)];
+
+	m_device->unmapBuffer(m_readback[oldest]);
+}
+
+DrawItem MeshletMesh::get_draw_item(const u32 instance) const {
+	DrawItem item = {};
+	item.vertex_buffer = m_vertex_buffer;
+	item.index_buffer = m_index_buffer;
+	item.index_format = nvrhi::Format::R32_UINT;
+	item.indirect_buffer = m_argument_buffer;
+	item.indirect_offset = static_cast<u32>(instance * m_meshlet_count * sizeof(nvrhi::DrawIndexedIndirectArguments));
+	item.indirect_count = m_meshlet_count;
+
+	return item;
+}
+
+} // namespace vg::gfx
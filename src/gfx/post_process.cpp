@@ -0,0 +1,358 @@
+#include <glm/matrix.hpp>
+#include <glm/vec4.hpp>
+
+#include <nvrhi/utils.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "gfx/post_process.hpp"
+#include "metrics.hpp"
+
+namespace vg::gfx {
+
+// NOTE: must match the PostConstants struct in shaders/post_process.hlsli
+struct PostConstants {
+	glm::mat4 reprojection;
+	glm::vec4 size; // destination size, inverse size
+	glm::vec4 source_size; // source size, inverse size
+	glm::vec4 params; // pass specific
+};
+
+static f32 halton(u32 index, const u32 base) {
+	f32 result = 0.f;
+	f32 fraction = 1.f;
+
+	while (index > 0) {
+		fraction /= static_cast<f32>(base);
+		result += fraction * static_cast<f32>(index % base);
+		index /= base;
+	}
+
+	return result;
+}
+
+static glm::vec4 texture_size(nvrhi::ITexture* texture) {
+	const auto& desc = texture->getDesc();
+	const auto width = static_cast<f32>(desc.width);
+	const auto height = static_cast<f32>(desc.height);
+	return {width, height, 1.f / width, 1.f / height};
+}
+
+static nvrhi::TextureDesc target_desc(
+	const char* name,
+	const u32 width,
+	const u32 height,
+	const nvrhi::Format format,
+	const nvrhi::ResourceStates state
+) {
+	nvrhi::TextureDesc desc = {};
+	desc.setDebugName(name);
+	desc.setWidth(width);
+	desc.setHeight(height);
+	desc.setFormat(format);
+	desc.setDimension(nvrhi::TextureDimension::Texture2D);
+	desc.enableAutomaticStateTracking(state);
+	return desc;
+}
+
+PostProcess::PostProcess(IDevice& device, const PostProcessShaders& shaders) : m_device(device) {
+	auto handle = device.get_device();
+
+	// without a compute queue post processing runs on the graphics queue, the gauge tells the two apart
+	m_async = handle->queryFeatureSupport(nvrhi::Feature::ComputeQueue);
+	MetricsRegistry::global().gauge("post_process_async").set(m_async ? 1.0 : 0.0);
+
+	m_taa = create_pass(shaders.taa, 2, 2);
+	m_downsample = create_pass(shaders.bloom_downsample, 0, 2);
+	m_upsample = create_pass(shaders.bloom_upsample, 0, 2);
+	m_tonemap = create_pass(shaders.tonemap, 0, 3);
+
+	const auto queue = m_async ? nvrhi::CommandQueue::Compute : nvrhi::CommandQueue::Graphics;
+	m_compute_list = handle->createCommandList(nvrhi::CommandListParameters().setQueueType(queue));
+	m_handoff_list = handle->createCommandList();
+	m_composite_list = handle->createCommandList();
+}
+
+nvrhi::IFramebuffer* PostProcess::begin_frame(const u32 width, const u32 height) {
+	if (width != m_width || height != m_height)
+		create_targets(width, height);
+
+	return m_frames[m_frame % FRAME_COUNT].framebuffer;
+}
+
+glm::mat4 PostProcess::jitter(const glm::mat4& projection) const {
+	if (!m_settings.taa || m_width == 0 || m_height == 0)
+		return projection;
+
+	const u32 index = static_cast<u32>(m_frame % JITTER_SAMPLES) + 1;
+	const glm::vec2 offset = glm::vec2(halton(index, 2), halton(index, 3)) - .5f;
+
+	// the z column is multiplied by view depth, which ends up as w, so the shift is constant in ndc
+	glm::mat4 result = projection;
+	result[2][0] += offset.x * 2.f / static_cast<f32>(m_width);
+	result[2][1] += offset.y * 2.f / static_cast<f32>(m_height);
+	return result;
+}
+
+void PostProcess::execute(
+	nvrhi::ICommandList* scene_commands,
+	const glm::mat4& view_projection,
+	nvrhi::IFramebuffer* target
+) {
+	auto device = m_device.get_device();
+	Frame& frame = m_frames[m_frame % FRAME_COUNT];
+
+	// NOTE: nvrhi has no non pixel shader resource state, ShaderResource covers both stages. compute lists may read
+	// a resource in it but not transition into or out of it, so the scene targets are moved here on the graphics
+	// queue, before the compute queue waits, and the compute list finds them in the state it binds them in
+	m_handoff_list->open();
+	m_handoff_list->setTextureState(frame.color, nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
+	m_handoff_list->setTextureState(frame.depth, nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
+	m_handoff_list->commitBarriers();
+	m_handoff_list->close();
+
+	nvrhi::ICommandList* graphics_lists[] = {scene_commands, m_handoff_list};
+	const u64 scene_instance = device->executeCommandLists(graphics_lists, std::size(graphics_lists));
+
+	m_compute_list->open();
+	record(frame, view_projection);
+	m_compute_list->close();
+
+	if (m_async) {
+		device->queueWaitForCommandList(nvrhi::CommandQueue::Compute, nvrhi::CommandQueue::Graphics, scene_instance);
+		frame.instance = device->executeCommandList(m_compute_list, nvrhi::CommandQueue::Compute);
+	} else {
+		frame.instance = device->executeCommandList(m_compute_list);
+	}
+
+	// async mode shows the previous frame, which the compute queue worked on while this one was rendered
+	const Frame& shown = m_async ? m_frames[(m_frame + FRAME_COUNT - 1) % FRAME_COUNT] : frame;
+	const bool ready = !m_async || m_history_frames > 0;
+
+	if (m_async && ready)
+		device->queueWaitForCommandList(nvrhi::CommandQueue::Graphics, nvrhi::CommandQueue::Compute, shown.instance);
+
+	m_composite_list->open();
+
+	if (ready) {
+		m_composite_list->copyTexture(
+			target->getDesc().colorAttachments[0].texture,
+			nvrhi::TextureSlice(),
+			shown.output,
+			nvrhi::TextureSlice()
+		);
+	} else {
+		nvrhi::utils::ClearColorAttachment(m_composite_list, target, 0, nvrhi::Color(0.f));
+	}
+
+	m_composite_list->close();
+	device->executeCommandList(m_composite_list);
+
+	m_previous_view_projection = view_projection;
+	m_history_frames++;
+	m_frame++;
+}
+
+PostProcess::Pass PostProcess::create_pass(nvrhi::IShader* shader, const u32 srv_count, const u32 uav_count) {
+	auto& cache = m_device.get_cache();
+
+	nvrhi::BindingLayoutDesc layout_desc = {};
+	layout_desc.setVisibility(nvrhi::ShaderType::Compute);
+	layout_desc.addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(PostConstants)));
+
+	for (u32 i = 0; i < srv_count; i++) {
+		layout_desc.addItem(nvrhi::BindingLayoutItem::Texture_SRV(i));
+	}
+	for (u32 i = 0; i < uav_count; i++) {
+		layout_desc.addItem(nvrhi::BindingLayoutItem::Texture_UAV(i));
+	}
+
+	Pass pass;
+	pass.layout = cache.get_binding_layout(layout_desc);
+
+	nvrhi::ComputePipelineDesc pipeline_desc = {};
+	pipeline_desc.setComputeShader(shader);
+	pipeline_desc.addBindingLayout(pass.layout);
+
+	pass.pipeline = cache.get_compute_pipeline(pipeline_desc);
+	return pass;
+}
+
+// NOTE: these sets reference size dependent targets, after a resize the cache drops the old ones
+// once nothing else holds them
+nvrhi::BindingSetHandle PostProcess::create_binding_set(
+	const Pass& pass,
+	std::initializer_list<nvrhi::ITexture*> srvs,
+	std::initializer_list<nvrhi::ITexture*> uavs
+) {
+	nvrhi::BindingSetDesc desc = {};
+	desc.addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(PostConstants)));
+
+	u32 slot = 0;
+	for (nvrhi::ITexture* texture : srvs) {
+		desc.addItem(nvrhi::BindingSetItem::Texture_SRV(slot++, texture));
+	}
+
+	slot = 0;
+	for (nvrhi::ITexture* texture : uavs) {
+		desc.addItem(nvrhi::BindingSetItem::Texture_UAV(slot++, texture));
+	}
+
+	return m_device.get_cache().get_binding_set(desc, pass.layout);
+}
+
+void PostProcess::create_targets(const u32 width, const u32 height) {
+	auto device = m_device.get_device();
+	auto& memory = m_device.get_memory();
+
+	// the compute queue may still be reading the old targets
+	device->waitForIdle();
+
+	m_width = width;
+	m_height = height;
+	m_history_frames = 0;
+
+	// NOTE: compute lists can't transition to or from pixel shader states, so everything the compute
+	// queue touches either stays in the shader resource state (scene targets) or the unordered access
+	// state (intermediates and output). graphics lists transition and restore them around their own use
+	for (auto& frame : m_frames) {
+		auto color_desc = target_desc(
+			"scene_color",
+			width,
+			height,
+			COLOR_FORMAT,
+			nvrhi::ResourceStates::ShaderResource
+		);
+		color_desc.setIsRenderTarget(true);
+		color_desc.setUseClearValue(true);
+		color_desc.setClearValue(nvrhi::Color(0.f));
+
+		auto depth_desc = target_desc(
+			"scene_depth",
+			width,
+			height,
+			DEPTH_FORMAT,
+			nvrhi::ResourceStates::ShaderResource
+		);
+		depth_desc.setIsRenderTarget(true);
+		depth_desc.setIsTypeless(true);
+		depth_desc.setUseClearValue(true);
+		depth_desc.setClearValue(nvrhi::Color(1.f, 0.f, 0.f, 0.f));
+
+		auto output_desc = target_desc(
+			"post_output",
+			width,
+			height,
+			nvrhi::Format::RGBA8_UNORM,
+			nvrhi::ResourceStates::UnorderedAccess
+		);
+		output_desc.setIsUAV(true);
+
+		frame.color = memory.create_texture(color_desc, MemoryCategory::RenderTarget);
+		frame.depth = memory.create_texture(depth_desc, MemoryCategory::RenderTarget);
+		frame.output = memory.create_texture(output_desc, MemoryCategory::RenderTarget);
+
+		frame.framebuffer = device->createFramebuffer(
+			nvrhi::FramebufferDesc().addColorAttachment(frame.color).setDepthAttachment(frame.depth)
+		);
+	}
+
+	for (auto& history : m_history) {
+		auto desc = target_desc("taa_history", width, height, COLOR_FORMAT, nvrhi::ResourceStates::UnorderedAccess);
+		desc.setIsUAV(true);
+		history = memory.create_texture(desc, MemoryCategory::RenderTarget);
+	}
+
+	m_bloom.resize(BLOOM_LEVELS);
+
+	for (u32 i = 0; i < BLOOM_LEVELS; i++) {
+		const u32 level_width = std::max(width >> (i + 1), 1u);
+		const u32 level_height = std::max(height >> (i + 1), 1u);
+
+		auto desc = target_desc(
+			"bloom",
+			level_width,
+			level_height,
+			COLOR_FORMAT,
+			nvrhi::ResourceStates::UnorderedAccess
+		);
+		desc.setIsUAV(true);
+		m_bloom[i] = memory.create_texture(desc, MemoryCategory::RenderTarget);
+	}
+
+	for (u32 i = 0; i < FRAME_COUNT; i++) {
+		Frame& frame = m_frames[i];
+		nvrhi::ITexture* history = m_history[i];
+		nvrhi::ITexture* previous_history = m_history[(i + FRAME_COUNT - 1) % FRAME_COUNT];
+
+		frame.taa_set = create_binding_set(m_taa, {frame.color, frame.depth}, {previous_history, history});
+		frame.downsample_set = create_binding_set(m_downsample, {}, {history, m_bloom[0]});
+		frame.tonemap_set = create_binding_set(m_tonemap, {}, {history, m_bloom[0], frame.output});
+	}
+
+	m_downsample_sets.assign(BLOOM_LEVELS, nullptr);
+	m_upsample_sets.assign(BLOOM_LEVELS - 1, nullptr);
+
+	for (u32 i = 1; i < BLOOM_LEVELS; i++) {
+		m_downsample_sets[i] = create_binding_set(m_downsample, {}, {m_bloom[i - 1], m_bloom[i]});
+	}
+	for (u32 i = 0; i + 1 < BLOOM_LEVELS; i++) {
+		m_upsample_sets[i] = create_binding_set(m_upsample, {}, {m_bloom[i + 1], m_bloom[i]});
+	}
+}
+
+void PostProcess::record(Frame& frame, const glm::mat4& view_projection) {
+	const auto dispatch = [&](const Pass& pass, nvrhi::IBindingSet* binding_set, const PostConstants& constants) {
+		nvrhi::ComputeState state;
+		state.setPipeline(pass.pipeline);
+		state.addBindingSet(binding_set);
+
+		m_compute_list->setComputeState(state);
+		m_compute_list->setPushConstants(&constants, sizeof(PostConstants));
+
+		const auto width = static_cast<u32>(constants.size.x);
+		const auto height = static_cast<u32>(constants.size.y);
+		m_compute_list->dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE);
+	};
+
+	const glm::vec4 screen_size = texture_size(frame.color);
+
+	PostConstants taa = {};
+	taa.reprojection = m_previous_view_projection * glm::inverse(view_projection);
+	taa.size = screen_size;
+	taa.source_size = screen_size;
+	taa.params = glm::vec4(m_settings.taa ? m_settings.taa_blend : 1.f, m_history_frames > 0 ? 1.f : 0.f, 0.f, 0.f);
+
+	dispatch(m_taa, frame.taa_set, taa);
+
+	if (m_settings.bloom) {
+		for (u32 i = 0; i < BLOOM_LEVELS; i++) {
+			PostConstants downsample = {};
+			downsample.size = texture_size(m_bloom[i]);
+			downsample.source_size = i == 0 ? screen_size : texture_size(m_bloom[i - 1]);
+			downsample.params =
+				glm::vec4(m_settings.bloom_threshold, m_settings.bloom_knee, i == 0 ? 1.f : 0.f, 0.f);
+
+			dispatch(m_downsample, i == 0 ? frame.downsample_set : m_downsample_sets[i], downsample);
+		}
+
+		for (u32 i = BLOOM_LEVELS - 1; i-- > 0;) {
+			PostConstants upsample = {};
+			upsample.size = texture_size(m_bloom[i]);
+			upsample.source_size = texture_size(m_bloom[i + 1]);
+			upsample.params = glm::vec4(m_settings.bloom_radius, 0.f, 0.f, 0.f);
+
+			dispatch(m_upsample, m_upsample_sets[i], upsample);
+		}
+	}
+
+	PostConstants tonemap = {};
+	tonemap.size = screen_size;
+	tonemap.source_size = texture_size(m_bloom[0]);
+	tonemap.params = glm::vec4(m_settings.exposure, m_settings.bloom ? m_settings.bloom_intensity : 0.f, 0.f, 0.f);
+
+	dispatch(m_tonemap, frame.tonemap_set, tonemap);
+}
+
+} // namespace vg::gfx
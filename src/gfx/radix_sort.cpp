@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "gfx/radix_sort.hpp"
+
+namespace vg::gfx {
+
+RadixSort::RadixSort(ThreadPool* thread_pool) : m_thread_pool(thread_pool) {}
+
+// LSD radix sort over 8-bit digits, each block of entries is histogrammed and scattered on its own thread
+void RadixSort::sort(std::span<SortEntry> entries) {
+	const usize count = entries.size();
+	if (count <= 1)
+		return;
+
+	const bool parallel = m_thread_pool != nullptr && count >= PARALLEL_THRESHOLD;
+	const usize blocks = parallel ? m_thread_pool->get_thread_count() + 1 : 1;
+	const usize block_size = (count + blocks - 1) / blocks;
+
+	m_scratch.resize(count);
+	m_histograms.resize(blocks);
+
+	SortEntry* src = entries.data();
+	SortEntry* dst = m_scratch.data();
+
+	const auto for_each_block = [&](const auto& fn) {
+		const auto run = [&](const usize begin, const usize end) {
+			for (usize block = begin; block < end; block++) {
+				fn(block, block * block_size, std::min((block + 1) * block_size, count));
+			}
+		};
+
+		if (parallel)
+			m_thread_pool->parallel_for(blocks, 1, run);
+		else
+			run(0, blocks);
+	};
+
+	for (u32 shift = 0; shift < 64; shift += 8) {
+		for_each_block([&](const usize block, const usize begin, const usize end) {
+			auto& histogram = m_histograms[block];
+			histogram.fill(0);
+
+			for (usize i = begin; i < end; i++) {
+				histogram[(src[i].key >> shift) & 0xff]++;
+			}
+		});
+
+		// turn the counts into per-block output offsets, skipping passes where every key shares the digit
+		usize offset = 0;
+		bool trivial = false;
+
+		for (usize digit = 0; digit < 256; digit++) {
+			usize total = 0;
+
+			for (auto& histogram : m_histograms) {
+				const usize digit_count = histogram[digit];
+				histogram[digit] = offset + total;
+				total += digit_count;
+			}
+
+			if (total == count)
+				trivial = true;
+
+			offset += total;
+		}
+
+		if (trivial)
+			continue;
+
+		for_each_block([&](const usize block, const usize begin, const usize end) {
+			auto& histogram = m_histograms[block];
+
+			for (usize i = begin; i < end; i++) {
+				dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+			}
+		});
+
+		std::swap(src, dst);
+	}
+
+	if (src != entries.data()) {
+		std::copy_n(src, count, entries.data());
+	}
+}
+
+} // namespace vg::gfx
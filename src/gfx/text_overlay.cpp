@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <array>
+
+#include "gfx/text_overlay.hpp"
+
+namespace vg::gfx {
+
+static constexpr u32 GLYPH_COLUMNS = 3;
+static constexpr u32 GLYPH_ROWS = 5;
+static constexpr u32 ADVANCE = GLYPH_COLUMNS + 1; // in cells
+static constexpr u32 LINE_HEIGHT = GLYPH_ROWS + 2; // in cells
+static constexpr u32 PADDING = 3; // cells between the panel edge and the text
+
+static constexpr u32 PANEL_BITS = (1u << (GLYPH_COLUMNS * GLYPH_ROWS)) - 1;
+static constexpr u32 PANEL_COLOR = 0xb0100c0c;
+
+static constexpr char FIRST_CHAR = ' ';
+static constexpr char LAST_CHAR = '_';
+
+// indexed by character - FIRST_CHAR
+static constexpr std::array<u16, LAST_CHAR - FIRST_CHAR + 1> FONT = {
+	0x0000, 0x2092, 0x002d, 0x5f7d, 0x3c9e, 0x52a5, 0x6aaa, 0x0012,
+	0x4494, 0x1491, 0x0aa8, 0x05d0, 0x1400, 0x01c0, 0x2000, 0x12a4,
+	0x7b6f, 0x749a, 0x73e7, 0x79a7, 0x49ed, 0x79cf, 0x7bcf, 0x2527,
+	0x7bef, 0x79ef, 0x0410, 0x1410, 0x4454, 0x0e38, 0x1511, 0x21a7,
+	0x73ef, 0x5bea, 0x3aeb, 0x624e, 0x3b6b, 0x72cf, 0x12cf, 0x6b4e,
+	0x5bed, 0x7497, 0x2b24, 0x5aed, 0x7249, 0x5bfd, 0x5b6b, 0x2b6a,
+	0x12eb, 0x676a, 0x5aeb, 0x388e, 0x2497, 0x7b6d, 0x2b6d, 0x5fed,
+	0x5aad, 0x24ad, 0x72a7, 0x324b, 0x4889, 0x6926, 0x002a, 0x7000,
+};
+
+static u32 get_glyph_bits(char c) {
+	if (c >= 'a' && c <= 'z')
+		c = static_cast<char>(c - 'a' + 'A');
+	if (c < FIRST_CHAR || c > LAST_CHAR)
+		c = '?';
+
+	return FONT[c - FIRST_CHAR];
+}
+
+TextOverlay::TextOverlay(IDevice& device, nvrhi::ShaderHandle vertex_shader, nvrhi::ShaderHandle pixel_shader) :
+	m_device(device),
+	m_upload_bytes(MetricsRegistry::global().counter("upload_bytes")) {
+	auto& cache = device.get_cache();
+
+	nvrhi::BufferDesc glyph_desc = {};
+	glyph_desc.setByteSize(MAX_GLYPHS * sizeof(GpuGlyph));
+	glyph_desc.setStructStride(sizeof(GpuGlyph));
+	glyph_desc.enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+	glyph_desc.setDebugName("overlay_glyphs");
+
+	m_glyph_buffer = device.get_memory().create_buffer(glyph_desc, MemoryCategory::Streamed);
+
+	nvrhi::BindingLayoutDesc layout_desc = {};
+	layout_desc.setVisibility(nvrhi::ShaderType::All);
+	layout_desc.addItem(nvrhi::BindingLayoutItem::PushConstants(0, sizeof(glm::vec2)));
+	layout_desc.addItem(nvrhi::BindingLayoutItem::StructuredBuffer_SRV(0));
+
+	m_binding_layout = cache.get_binding_layout(layout_desc);
+
+	nvrhi::BindingSetDesc set_desc = {};
+	set_desc.addItem(nvrhi::BindingSetItem::PushConstants(0, sizeof(glm::vec2)));
+	set_desc.addItem(nvrhi::BindingSetItem::StructuredBuffer_SRV(0, m_glyph_buffer));
+
+	m_binding_set = cache.get_binding_set(set_desc, m_binding_layout);
+
+	m_pipeline_desc.setVertexShader(vertex_shader);
+	m_pipeline_desc.setFragmentShader(pixel_shader);
+	m_pipeline_desc.addBindingLayout(m_binding_layout);
+
+	m_pipeline_desc.renderState.rasterState.setCullNone();
+	m_pipeline_desc.renderState.depthStencilState.setDepthTestEnable(false).setDepthWriteEnable(false);
+	m_pipeline_desc.renderState.blendState.targets[0]
+		.setBlendEnable(true)
+		.setSrcBlend(nvrhi::BlendFactor::SrcAlpha)
+		.setDestBlend(nvrhi::BlendFactor::InvSrcAlpha);
+
+	clear();
+}
+
+void TextOverlay::clear() {
+	m_glyphs.clear();
+	m_glyphs.push_back({});
+	m_line_count = 0;
+	m_columns = 0;
+	m_dirty = true;
+}
+
+void TextOverlay::add_line(const std::string_view text, const u32 color) {
+	const f32 cell = CELL_SIZE;
+	const f32 y = MARGIN + cell * (PADDING + m_line_count * LINE_HEIGHT);
+
+	for (usize i = 0; i < text.size() && m_glyphs.size() < MAX_GLYPHS; i++) {
+		const u32 bits = get_glyph_bits(text[i]);
+		if (bits == 0)
+			continue;
+
+		const f32 x = MARGIN + cell * (PADDING + i * ADVANCE);
+
+		GpuGlyph glyph = {};
+		glyph.rect = glm::vec4(x, y, cell * GLYPH_COLUMNS, cell * GLYPH_ROWS);
+		glyph.bits = bits;
+		glyph.color = color;
+		m_glyphs.push_back(glyph);
+	}
+
+	m_line_count++;
+	m_columns = std::max(m_columns, static_cast<u32>(text.size()));
+	m_dirty = true;
+}
+
+void TextOverlay::submit(nvrhi::ICommandList* command_list, DrawQueue& queue, nvrhi::IFramebuffer* framebuffer) {
+	// NOTE: only the panel, nothing to draw
+	if (m_glyphs.size() == 1)
+		return;
+
+	const auto& info = framebuffer->getFramebufferInfo();
+
+	if (m_dirty) {
+		// NOTE: the last column and line have no spacing after them
+		GpuGlyph& panel = m_glyphs[0];
+		panel.rect = glm::vec4(
+			MARGIN,
+			MARGIN,
+			CELL_SIZE * (m_columns * ADVANCE - (ADVANCE - GLYPH_COLUMNS) + 2 * PADDING),
+			CELL_SIZE * (m_line_count * LINE_HEIGHT - (LINE_HEIGHT - GLYPH_ROWS) + 2 * PADDING)
+		);
+		panel.bits = PANEL_BITS;
+		panel.color = PANEL_COLOR;
+
+		const usize bytes = m_glyphs.size() * sizeof(GpuGlyph);
+		command_list->writeBuffer(m_glyph_buffer, m_glyphs.data(), bytes);
+		m_upload_bytes.add(bytes);
+		m_dirty = false;
+	}
+
+	// NOTE: the pipeline only depends on the framebuffer formats, it is looked up again when they change
+	if (!m_pipeline || !(m_framebuffer_info == info)) {
+		m_pipeline = m_device.get_cache().get_graphics_pipeline(m_pipeline_desc, info);
+		m_framebuffer_info = info;
+	}
+
+	DrawItem draw = {};
+	draw.pipeline = m_pipeline;
+	draw.binding_sets = {m_binding_set};
+	draw.args.setVertexCount(static_cast<u32>(m_glyphs.size()) * 6);
+	draw.set_push_constants(glm::vec2(1.f / info.width, 1.f / info.height));
+
+	queue.submit(draw, DrawLayer::Overlay, true, 0.f);
+}
+
+} // namespace vg::gfx
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "metrics.hpp"
+
+namespace vg {
+
+f64 HistogramSnapshot::percentile(const f64 quantile) const {
+	if (count == 0)
+		return 0.0;
+
+	const f64 target = std::clamp(quantile, 0.0, 1.0) * static_cast<f64>(count);
+	u64 cumulative = 0;
+
+	for (usize i = 0; i < counts.size(); i++) {
+		if (counts[i] == 0 || static_cast<f64>(cumulative + counts[i]) < target) {
+			cumulative += counts[i];
+			continue;
+		}
+
+		const f64 lower = i > 0 ? bounds[i - 1] : 0.0;
+
+		// the overflow bucket has no upper bound to interpolate towards
+		if (i == bounds.size())
+			return lower;
+
+		const f64 fraction = (target - static_cast<f64>(cumulative)) / static_cast<f64>(counts[i]);
+		return lower + (bounds[i] - lower) * fraction;
+	}
+
+	return bounds.empty() ? 0.0 : bounds.back();
+}
+
+HistogramSnapshot HistogramSnapshot::since(const HistogramSnapshot& previous) const {
+	HistogramSnapshot delta = *this;
+
+	// NOTE: previous may be empty when the histogram didn't exist yet
+	if (previous.counts.size() != counts.size())
+		return delta;
+
+	for (usize i = 0; i < counts.size(); i++) {
+		delta.counts[i] -= std::min(previous.counts[i], counts[i]);
+	}
+
+	delta.count -= std::min(previous.count, count);
+	delta.sum -= previous.sum;
+
+	return delta;
+}
+
+Histogram::Histogram(std::span<const f64> bounds) :
+	m_bounds(bounds.begin(), bounds.end()), m_counts(bounds.size() + 1) {
+	if (!std::ranges::is_sorted(m_bounds))
+		throw std::runtime_error("Histogram bounds must be sorted");
+}
+
+std::vector<f64> Histogram::exponential_bounds(const f64 first, const f64 factor, const u32 count) {
+	std::vector<f64> bounds(count);
+	f64 bound = first;
+
+	for (auto& value : bounds) {
+		value = bound;
+		bound *= factor;
+	}
+
+	return bounds;
+}
+
+void Histogram::record(const f64 value) {
+	const auto bucket = std::ranges::lower_bound(m_bounds, value) - m_bounds.begin();
+
+	m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+	HistogramSnapshot snapshot;
+	snapshot.bounds = m_bounds;
+	snapshot.counts.reserve(m_counts.size());
+
+	for (const auto& count : m_counts) {
+		snapshot.counts.push_back(count.load(std::memory_order_relaxed));
+	}
+
+	snapshot.count = m_count.load(std::memory_order_relaxed);
+	snapshot.sum = m_sum.load(std::memory_order_relaxed);
+
+	return snapshot;
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+	static MetricsRegistry registry;
+	return registry;
+}
+
+template<typename T, typename... Args>
+T& MetricsRegistry::get_or_create(
+	std::vector<std::unique_ptr<T>>& storage,
+	const MetricKind kind,
+	const std::string_view name,
+	const std::string_view tags,
+	Args&&... args
+) {
+	std::string key;
+	key.reserve(name.size() + tags.size() + 1);
+	key.append(name).append(",").append(tags);
+
+	std::lock_guard lock(m_mutex);
+
+	if (const auto it = m_lookup.find(key); it != m_lookup.end()) {
+		const Entry& entry = m_entries[it->second];
+		if (entry.kind != kind)
+			throw std::runtime_error("Metric registered again with a different kind");
+
+		return *static_cast<T*>(entry.metric);
+	}
+
+	auto& metric = storage.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
+
+	m_lookup.emplace(std::move(key), m_entries.size());
+	m_entries.push_back({std::string(name), std::string(tags), kind, metric.get()});
+
+	return *metric;
+}
+
+Counter& MetricsRegistry::counter(const std::string_view name, const std::string_view tags) {
+	return get_or_create(m_counters, MetricKind::Counter, name, tags);
+}
+
+Gauge& MetricsRegistry::gauge(const std::string_view name, const std::string_view tags) {
+	return get_or_create(m_gauges, MetricKind::Gauge, name, tags);
+}
+
+Histogram& MetricsRegistry::histogram(
+	const std::string_view name,
+	std::span<const f64> bounds,
+	const std::string_view tags
+) {
+	return get_or_create(m_histograms, MetricKind::Histogram, name, tags, bounds);
+}
+
+MetricsSnapshot MetricsRegistry::snapshot() const {
+	MetricsSnapshot snapshot;
+	snapshot.time = std::chrono::system_clock::now();
+
+	// NOTE: only contends with registration, recording never takes this lock
+	std::lock_guard lock(m_mutex);
+	snapshot.metrics.reserve(m_entries.size());
+
+	for (const auto& entry : m_entries) {
+		MetricSnapshot metric;
+		metric.name = entry.name;
+		metric.tags = entry.tags;
+		metric.kind = entry.kind;
+
+		switch (entry.kind) {
+			case MetricKind::Counter:
+				metric.count = static_cast<const Counter*>(entry.metric)->get();
+				break;
+			case MetricKind::Gauge:
+				metric.value = static_cast<const Gauge*>(entry.metric)->get();
+				break;
+			case MetricKind::Histogram:
+				metric.histogram = static_cast<const Histogram*>(entry.metric)->snapshot();
+				break;
+		}
+
+		snapshot.metrics.push_back(std::move(metric));
+	}
+
+	return snapshot;
+}
+
+} // namespace vg
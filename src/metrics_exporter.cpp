@@ -0,0 +1,185 @@
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include "metrics_exporter.hpp"
+
+namespace vg {
+
+struct MetricsExporter::UdpSink {
+	SOCKET handle = INVALID_SOCKET;
+	sockaddr_storage address = {};
+	int address_size = 0;
+
+	explicit UdpSink(const std::string& endpoint) {
+		const auto separator = endpoint.rfind(':');
+		if (separator == std::string::npos)
+			throw std::runtime_error("Metrics udp endpoint must be host:port");
+
+		const std::string host = endpoint.substr(0, separator);
+		const std::string port = endpoint.substr(separator + 1);
+
+		WSADATA data;
+		if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+			throw std::runtime_error("Failed to initialize winsock");
+
+		addrinfo hints = {};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		hints.ai_protocol = IPPROTO_UDP;
+
+		addrinfo* result = nullptr;
+		if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr) {
+			WSACleanup();
+			throw std::runtime_error("Failed to resolve metrics udp endpoint");
+		}
+
+		std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+		address_size = static_cast<int>(result->ai_addrlen);
+		handle = socket(result->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+		freeaddrinfo(result);
+
+		if (handle == INVALID_SOCKET) {
+			WSACleanup();
+			throw std::runtime_error("Failed to create metrics udp socket");
+		}
+	}
+
+	~UdpSink() {
+		closesocket(handle);
+		WSACleanup();
+	}
+
+	UdpSink(const UdpSink&) = delete;
+	UdpSink& operator=(const UdpSink&) = delete;
+
+	void send(const std::string_view datagram) const {
+		// NOTE: fire and forget, nothing listening on the other end is not an error
+		sendto(
+			handle,
+			datagram.data(),
+			static_cast<int>(datagram.size()),
+			0,
+			reinterpret_cast<const sockaddr*>(&address),
+			address_size
+		);
+	}
+};
+
+MetricsExporter::MetricsExporter(MetricsRegistry& registry, MetricsExportOptions options) :
+	m_registry(registry), m_options(std::move(options)) {
+	if (!m_options.file.empty()) {
+		m_file.open(m_options.file, std::ios::app);
+		if (!m_file)
+			throw std::runtime_error("Failed to open metrics file");
+	}
+
+	if (!m_options.udp.empty())
+		m_udp = std::make_unique<UdpSink>(m_options.udp);
+
+	m_thread = std::jthread([this](const std::stop_token& stop) { run(stop); });
+}
+
+MetricsExporter::~MetricsExporter() = default;
+
+std::string MetricsExporter::format(const MetricsSnapshot& snapshot, const MetricsSnapshot& previous) {
+	const auto timestamp =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(snapshot.time.time_since_epoch()).count();
+
+	std::string lines;
+	const auto out = std::back_inserter(lines);
+
+	for (usize i = 0; i < snapshot.metrics.size(); i++) {
+		const MetricSnapshot& metric = snapshot.metrics[i];
+
+		// metrics are only ever appended, so the same index refers to the same metric
+		HistogramSnapshot interval = metric.histogram;
+		if (metric.kind == MetricKind::Histogram && i < previous.metrics.size())
+			interval = metric.histogram.since(previous.metrics[i].histogram);
+
+		if (metric.kind == MetricKind::Histogram && interval.count == 0)
+			continue;
+
+		std::format_to(out, "{},app=vanguard", metric.name);
+		if (!metric.tags.empty())
+			std::format_to(out, ",{}", metric.tags);
+
+		switch (metric.kind) {
+			case MetricKind::Counter:
+				std::format_to(out, " value={}i", metric.count);
+				break;
+			case MetricKind::Gauge:
+				std::format_to(out, " value={}", metric.value);
+				break;
+			case MetricKind::Histogram:
+				std::format_to(
+					out,
+					" count={}i,sum={},mean={},p50={},p95={},p99={}",
+					interval.count,
+					interval.sum,
+					interval.mean(),
+					interval.percentile(0.5),
+					interval.percentile(0.95),
+					interval.percentile(0.99)
+				);
+				break;
+		}
+
+		std::format_to(out, " {}\n", timestamp);
+	}
+
+	return lines;
+}
+
+void MetricsExporter::run(const std::stop_token& stop) {
+	while (!stop.stop_requested()) {
+		{
+			std::unique_lock lock(m_mutex);
+			m_condition.wait_for(lock, stop, m_options.interval, [] { return false; });
+		}
+
+		// NOTE: also runs once after a stop request, so the last partial interval is still exported
+		MetricsSnapshot snapshot = m_registry.snapshot();
+		write(format(snapshot, m_previous));
+		m_previous = std::move(snapshot);
+	}
+}
+
+void MetricsExporter::write(const std::string& lines) {
+	if (lines.empty())
+		return;
+
+	if (m_file.is_open()) {
+		m_file << lines;
+		m_file.flush();
+	}
+
+	if (!m_udp)
+		return;
+
+	// pack whole lines into datagrams, a line longer than a datagram is sent on its own
+	const std::string_view text = lines;
+	usize begin = 0;
+
+	while (begin < text.size()) {
+		usize end = begin;
+
+		while (end < text.size()) {
+			const usize line_end = text.find('\n', end) + 1;
+			if (line_end - begin > MAX_DATAGRAM_SIZE && end > begin)
+				break;
+
+			end = line_end;
+		}
+
+		m_udp->send(text.substr(begin, end - begin));
+		begin = end;
+	}
+}
+
+} // namespace vg
@@ -0,0 +1,37 @@
+#include "scene/bounds.hpp"
+
+namespace vg::scene {
+
+AABB AABB::transform(const glm::mat4& matrix) const {
+	// Arvo's method, transform the center and the absolute extents
+	const glm::vec3 c = center();
+	const glm::vec3 e = (max - min) * 0.5f;
+
+	const glm::vec3 new_center = glm::vec3(matrix * glm::vec4(c, 1.f));
+	const glm::vec3 new_extent = glm::abs(glm::vec3(matrix[0])) * e.x + glm::abs(glm::vec3(matrix[1])) * e.y
+		+ glm::abs(glm::vec3(matrix[2])) * e.z;
+
+	return {new_center - new_extent, new_center + new_extent};
+}
+
+Frustum Frustum::from_matrix(const glm::mat4& view_projection) {
+	const auto row = [&](const int i) {
+		return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+	};
+
+	Frustum frustum;
+	frustum.planes[0] = row(3) + row(0); // left
+	frustum.planes[1] = row(3) - row(0); // right
+	frustum.planes[2] = row(3) + row(1); // bottom
+	frustum.planes[3] = row(3) - row(1); // top
+	frustum.planes[4] = row(2); // near
+	frustum.planes[5] = row(3) - row(2); // far
+
+	for (auto& plane : frustum.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return frustum;
+}
+
+} // namespace vg::scene
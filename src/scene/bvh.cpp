@@ -0,0 +1,665 @@
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "scene/bvh.hpp"
+
+namespace vg::scene {
+
+static constexpr u32 SAH_BINS = 12;
+static constexpr f32 EMPTY_MIN = std::numeric_limits<f32>::max();
+static constexpr f32 EMPTY_MAX = std::numeric_limits<f32>::lowest();
+
+struct WideBounds {
+	__m128 min_x, min_y, min_z;
+	__m128 max_x, max_y, max_z;
+};
+
+template<typename Node>
+static WideBounds load_bounds(const Node& node) {
+	return {
+		_mm_load_ps(node.min_x),
+		_mm_load_ps(node.min_y),
+		_mm_load_ps(node.min_z),
+		_mm_load_ps(node.max_x),
+		_mm_load_ps(node.max_y),
+		_mm_load_ps(node.max_z),
+	};
+}
+
+static u32 test_frustum(const WideBounds& b, const Frustum& frustum) {
+	const __m128 zero = _mm_setzero_ps();
+	__m128 inside = _mm_cmpeq_ps(zero, zero);
+
+	for (const auto& plane : frustum.planes) {
+		// only the corner furthest along the plane normal matters
+		const __m128 x = plane.x >= 0.f ? b.max_x : b.min_x;
+		const __m128 y = plane.y >= 0.f ? b.max_y : b.min_y;
+		const __m128 z = plane.z >= 0.f ? b.max_z : b.min_z;
+
+		__m128 d = _mm_set1_ps(plane.w);
+		d = _mm_add_ps(d, _mm_mul_ps(x, _mm_set1_ps(plane.x)));
+		d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+		d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(plane.z)));
+
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+	}
+
+	return static_cast<u32>(_mm_movemask_ps(inside));
+}
+
+static u32 test_sphere(const WideBounds& b, const Sphere& sphere) {
+	const __m128 cx = _mm_set1_ps(sphere.center.x);
+	const __m128 cy = _mm_set1_ps(sphere.center.y);
+	const __m128 cz = _mm_set1_ps(sphere.center.z);
+
+	const __m128 dx = _mm_sub_ps(_mm_max_ps(b.min_x, _mm_min_ps(cx, b.max_x)), cx);
+	const __m128 dy = _mm_sub_ps(_mm_max_ps(b.min_y, _mm_min_ps(cy, b.max_y)), cy);
+	const __m128 dz = _mm_sub_ps(_mm_max_ps(b.min_z, _mm_min_ps(cz, b.max_z)), cz);
+
+	const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+	const __m128 radius = _mm_set1_ps(sphere.radius * sphere.radius);
+
+	return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(distance, radius)));
+}
+
+static u32 test_ray(const WideBounds& b, const Ray& ray, const glm::vec3& inv_dir, const f32 t_max, f32* t_near) {
+	const __m128 ox = _mm_set1_ps(ray.origin.x);
+	const __m128 oy = _mm_set1_ps(ray.origin.y);
+	const __m128 oz = _mm_set1_ps(ray.origin.z);
+	const __m128 ix = _mm_set1_ps(inv_dir.x);
+	const __m128 iy = _mm_set1_ps(inv_dir.y);
+	const __m128 iz = _mm_set1_ps(inv_dir.z);
+
+	const __m128 t1x = _mm_mul_ps(_mm_sub_ps(b.min_x, ox), ix);
+	const __m128 t2x = _mm_mul_ps(_mm_sub_ps(b.max_x, ox), ix);
+	const __m128 t1y = _mm_mul_ps(_mm_sub_ps(b.min_y, oy), iy);
+	const __m128 t2y = _mm_mul_ps(_mm_sub_ps(b.max_y, oy), iy);
+	const __m128 t1z = _mm_mul_ps(_mm_sub_ps(b.min_z, oz), iz);
+	const __m128 t2z = _mm_mul_ps(_mm_sub_ps(b.max_z, oz), iz);
+
+	__m128 t_min = _mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y));
+	t_min = _mm_max_ps(t_min, _mm_max_ps(_mm_min_ps(t1z, t2z), _mm_setzero_ps()));
+
+	__m128 t_exit = _mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y));
+	t_exit = _mm_min_ps(t_exit, _mm_min_ps(_mm_max_ps(t1z, t2z), _mm_set1_ps(t_max)));
+
+	// NOTE: empty slots have inverted bounds, which the slab test alone would treat as infinite
+	const __m128 valid = _mm_cmple_ps(b.min_x, b.max_x);
+	const __m128 hit = _mm_and_ps(_mm_cmple_ps(t_min, t_exit), valid);
+
+	_mm_storeu_ps(t_near, t_min);
+	return static_cast<u32>(_mm_movemask_ps(hit));
+}
+
+Bvh::Bvh(ThreadPool* thread_pool) : m_thread_pool(thread_pool) {}
+
+u32 Bvh::insert(const AABB& bounds, const u32 user_data) {
+	u32 proxy;
+
+	if (!m_free_proxies.empty()) {
+		proxy = m_free_proxies.back();
+		m_free_proxies.pop_back();
+	} else {
+		proxy = static_cast<u32>(m_proxies.size());
+		m_proxies.emplace_back();
+	}
+
+	const u32 leaf = allocate_node();
+	m_nodes[leaf].bounds = bounds;
+	m_nodes[leaf].proxy = proxy;
+
+	// NOTE: the top bit of user data is reserved to tag leaves in the wide nodes
+	m_proxies[proxy] = {bounds, user_data & ~WideNode::LEAF, leaf};
+	m_proxy_count++;
+
+	insert_leaf(leaf);
+	m_dirty = true;
+
+	return proxy;
+}
+
+void Bvh::remove(const u32 proxy) {
+	const u32 leaf = m_proxies[proxy].leaf;
+
+	remove_leaf(leaf);
+	free_node(leaf);
+
+	m_proxies[proxy] = {};
+	m_free_proxies.push_back(proxy);
+	m_proxy_count--;
+
+	m_dirty = true;
+}
+
+void Bvh::update(const u32 proxy, const AABB& bounds) {
+	const u32 leaf = m_proxies[proxy].leaf;
+
+	m_proxies[proxy].bounds = bounds;
+	m_nodes[leaf].bounds = bounds;
+
+	// NOTE: only a rotation changes which nodes the wide copy holds, plain bounds changes are patched in place
+	if (refit(m_nodes[leaf].parent))
+		m_dirty = true;
+	else if (!m_dirty)
+		refit_wide(leaf);
+}
+
+void Bvh::rebuild() {
+	std::vector<u32> leaves;
+	leaves.reserve(m_proxy_count);
+
+	for (const auto& proxy : m_proxies) {
+		if (proxy.leaf != INVALID)
+			leaves.push_back(proxy.leaf);
+	}
+
+	// drop every internal node, only the leaves survive
+	for (u32 node = 0; node < m_nodes.size(); node++) {
+		if (m_nodes[node].proxy == INVALID && !m_nodes[node].is_leaf())
+			free_node(node);
+	}
+
+	m_root = leaves.empty() ? INVALID : build_recursive(leaves);
+	if (m_root != INVALID)
+		m_nodes[m_root].parent = INVALID;
+
+	m_dirty = true;
+}
+
+void Bvh::query_frustum(const Frustum& frustum, std::vector<u32>& results) {
+	flatten();
+
+	traverse(
+		[&](const WideNode& node) { return test_frustum(load_bounds(node), frustum); },
+		[&](const u32 user_data, u32) { results.push_back(user_data); }
+	);
+}
+
+void Bvh::query_sphere(const Sphere& sphere, std::vector<u32>& results) {
+	flatten();
+
+	traverse(
+		[&](const WideNode& node) { return test_sphere(load_bounds(node), sphere); },
+		[&](const u32 user_data, u32) { results.push_back(user_data); }
+	);
+}
+
+RayHit Bvh::raycast(const Ray& ray) {
+	flatten();
+	return trace(ray);
+}
+
+void Bvh::query_frustums(std::span<const Frustum> frustums, std::span<std::vector<u32>> results) {
+	flatten();
+
+	const auto run = [&](const usize begin, const usize end) {
+		for (usize i = begin; i < end; i++) {
+			results[i].clear();
+			traverse(
+				[&](const WideNode& node) { return test_frustum(load_bounds(node), frustums[i]); },
+				[&](const u32 user_data, u32) { results[i].push_back(user_data); }
+			);
+		}
+	};
+
+	if (m_thread_pool != nullptr)
+		m_thread_pool->parallel_for(frustums.size(), 1, run);
+	else
+		run(0, frustums.size());
+}
+
+void Bvh::query_spheres(std::span<const Sphere> spheres, std::span<std::vector<u32>> results) {
+	flatten();
+
+	const auto run = [&](const usize begin, const usize end) {
+		for (usize i = begin; i < end; i++) {
+			results[i].clear();
+			traverse(
+				[&](const WideNode& node) { return test_sphere(load_bounds(node), spheres[i]); },
+				[&](const u32 user_data, u32) { results[i].push_back(user_data); }
+			);
+		}
+	};
+
+	if (m_thread_pool != nullptr)
+		m_thread_pool->parallel_for(spheres.size(), 16, run);
+	else
+		run(0, spheres.size());
+}
+
+void Bvh::raycast(std::span<const Ray> rays, std::span<RayHit> hits) {
+	flatten();
+
+	const auto run = [&](const usize begin, const usize end) {
+		for (usize i = begin; i < end; i++) {
+			hits[i] = trace(rays[i]);
+		}
+	};
+
+	if (m_thread_pool != nullptr)
+		m_thread_pool->parallel_for(rays.size(), 64, run);
+	else
+		run(0, rays.size());
+}
+
+f32 Bvh::get_cost() const {
+	if (m_root == INVALID)
+		return 0.f;
+
+	f32 area = 0.f;
+	for (u32 node = 0; node < m_nodes.size(); node++) {
+		if (m_nodes[node].proxy == INVALID && !m_nodes[node].is_leaf())
+			area += m_nodes[node].bounds.surface_area();
+	}
+
+	return area / std::max(m_nodes[m_root].bounds.surface_area(), 1e-6f);
+}
+
+u32 Bvh::allocate_node() {
+	if (!m_free_nodes.empty()) {
+		const u32 node = m_free_nodes.back();
+		m_free_nodes.pop_back();
+		m_nodes[node] = {};
+		return node;
+	}
+
+	m_nodes.emplace_back();
+	return static_cast<u32>(m_nodes.size() - 1);
+}
+
+void Bvh::free_node(const u32 node) {
+	m_nodes[node] = {};
+	m_free_nodes.push_back(node);
+}
+
+// picks the sibling with the lowest SAH cost (branch and bound descent, see Box2D's b2DynamicTree)
+void Bvh::insert_leaf(const u32 leaf) {
+	if (m_root == INVALID) {
+		m_root = leaf;
+		m_nodes[leaf].parent = INVALID;
+		return;
+	}
+
+	const AABB bounds = m_nodes[leaf].bounds;
+	u32 index = m_root;
+
+	while (!m_nodes[index].is_leaf()) {
+		const Node& node = m_nodes[index];
+
+		const f32 area = node.bounds.surface_area();
+		const f32 combined_area = AABB::merge(node.bounds, bounds).surface_area();
+
+		const f32 cost = 2.f * combined_area;
+		const f32 inheritance_cost = 2.f * (combined_area - area);
+
+		const auto child_cost = [&](const u32 child) {
+			const f32 merged = AABB::merge(bounds, m_nodes[child].bounds).surface_area();
+			if (m_nodes[child].is_leaf())
+				return merged + inheritance_cost;
+			return merged - m_nodes[child].bounds.surface_area() + inheritance_cost;
+		};
+
+		const f32 cost_left = child_cost(node.left);
+		const f32 cost_right = child_cost(node.right);
+
+		if (cost < cost_left && cost < cost_right)
+			break;
+
+		index = cost_left < cost_right ? node.left : node.right;
+	}
+
+	const u32 sibling = index;
+	const u32 old_parent = m_nodes[sibling].parent;
+	const u32 new_parent = allocate_node();
+
+	m_nodes[new_parent].parent = old_parent;
+	m_nodes[new_parent].bounds = AABB::merge(bounds, m_nodes[sibling].bounds);
+	m_nodes[new_parent].left = sibling;
+	m_nodes[new_parent].right = leaf;
+
+	m_nodes[sibling].parent = new_parent;
+	m_nodes[leaf].parent = new_parent;
+
+	if (old_parent == INVALID) {
+		m_root = new_parent;
+	} else if (m_nodes[old_parent].left == sibling) {
+		m_nodes[old_parent].left = new_parent;
+	} else {
+		m_nodes[old_parent].right = new_parent;
+	}
+
+	refit(old_parent);
+}
+
+void Bvh::remove_leaf(const u32 leaf) {
+	if (leaf == m_root) {
+		m_root = INVALID;
+		return;
+	}
+
+	const u32 parent = m_nodes[leaf].parent;
+	const u32 grandparent = m_nodes[parent].parent;
+	const u32 sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+	m_nodes[sibling].parent = grandparent;
+
+	if (grandparent == INVALID) {
+		m_root = sibling;
+	} else {
+		if (m_nodes[grandparent].left == parent)
+			m_nodes[grandparent].left = sibling;
+		else
+			m_nodes[grandparent].right = sibling;
+	}
+
+	free_node(parent);
+	refit(grandparent);
+}
+
+bool Bvh::refit(u32 node) {
+	bool rotated = false;
+
+	while (node != INVALID) {
+		m_nodes[node].bounds = AABB::merge(m_nodes[m_nodes[node].left].bounds, m_nodes[m_nodes[node].right].bounds);
+		rotated |= rotate(node);
+		node = m_nodes[node].parent;
+	}
+
+	return rotated;
+}
+
+// copies the bounds of the node and its ancestors into the wide slots that hold them
+void Bvh::refit_wide(u32 node) {
+	while (node != INVALID) {
+		const Node& binary = m_nodes[node];
+
+		// nodes opened while flattening have no slot of their own, their children carry the bounds
+		if (binary.wide != INVALID) {
+			WideNode& wide = m_wide_nodes[binary.wide];
+			wide.min_x[binary.slot] = binary.bounds.min.x;
+			wide.min_y[binary.slot] = binary.bounds.min.y;
+			wide.min_z[binary.slot] = binary.bounds.min.z;
+			wide.max_x[binary.slot] = binary.bounds.max.x;
+			wide.max_y[binary.slot] = binary.bounds.max.y;
+			wide.max_z[binary.slot] = binary.bounds.max.z;
+		}
+
+		node = binary.parent;
+	}
+}
+
+// Kopta et al. 2012, "Fast, Effective BVH Updates for Animated Scenes"
+// swaps a child with a grandchild on the other side when that shrinks the grandchild's parent
+bool Bvh::rotate(const u32 node) {
+	const u32 left = m_nodes[node].left;
+	const u32 right = m_nodes[node].right;
+
+	f32 best_saving = 0.f;
+	u32 best_child = INVALID;
+	u32 best_grandchild = INVALID;
+	u32 best_other = INVALID;
+
+	for (const auto [child, other] : {std::pair(right, left), std::pair(left, right)}) {
+		if (m_nodes[child].is_leaf())
+			continue;
+
+		const f32 current = m_nodes[child].bounds.surface_area();
+		const u32 grandchildren[2] = {m_nodes[child].left, m_nodes[child].right};
+
+		for (u32 i = 0; i < 2; i++) {
+			const u32 keep = grandchildren[1 - i];
+			const f32 rotated = AABB::merge(m_nodes[other].bounds, m_nodes[keep].bounds).surface_area();
+
+			if (current - rotated > best_saving) {
+				best_saving = current - rotated;
+				best_child = child;
+				best_grandchild = grandchildren[i];
+				best_other = other;
+			}
+		}
+	}
+
+	if (best_child == INVALID)
+		return false;
+
+	// other takes the grandchild's place under child, the grandchild moves up under node
+	if (m_nodes[node].left == best_other)
+		m_nodes[node].left = best_grandchild;
+	else
+		m_nodes[node].right = best_grandchild;
+
+	if (m_nodes[best_child].left == best_grandchild)
+		m_nodes[best_child].left = best_other;
+	else
+		m_nodes[best_child].right = best_other;
+
+	m_nodes[best_grandchild].parent = node;
+	m_nodes[best_other].parent = best_child;
+
+	const Node& child = m_nodes[best_child];
+	m_nodes[best_child].bounds = AABB::merge(m_nodes[child.left].bounds, m_nodes[child.right].bounds);
+
+	return true;
+}
+
+// top-down binned SAH, one leaf per proxy so the result stays editable
+u32 Bvh::build_recursive(std::span<u32> leaves) {
+	if (leaves.size() == 1)
+		return leaves[0];
+
+	AABB centroid_bounds;
+	for (const u32 leaf : leaves) {
+		centroid_bounds.grow(m_nodes[leaf].bounds.center());
+	}
+
+	const glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+	const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	usize split = leaves.size() / 2;
+
+	if (extent[axis] > 0.f) {
+		const f32 scale = SAH_BINS / extent[axis];
+		const auto bin_of = [&](const u32 leaf) {
+			const f32 offset = m_nodes[leaf].bounds.center()[axis] - centroid_bounds.min[axis];
+			return std::min(static_cast<u32>(offset * scale), SAH_BINS - 1);
+		};
+
+		std::array<AABB, SAH_BINS> bin_bounds = {};
+		std::array<u32, SAH_BINS> bin_counts = {};
+
+		for (const u32 leaf : leaves) {
+			const u32 bin = bin_of(leaf);
+			bin_bounds[bin] = AABB::merge(bin_bounds[bin], m_nodes[leaf].bounds);
+			bin_counts[bin]++;
+		}
+
+		// sweep from the right to get the cost of everything past each split plane
+		std::array<f32, SAH_BINS> right_costs = {};
+		AABB right_bounds;
+		u32 right_count = 0;
+
+		for (u32 i = SAH_BINS - 1; i > 0; i--) {
+			right_bounds = AABB::merge(right_bounds, bin_bounds[i]);
+			right_count += bin_counts[i];
+			right_costs[i] = right_count > 0 ? right_bounds.surface_area() * static_cast<f32>(right_count) : 0.f;
+		}
+
+		f32 best_cost = std::numeric_limits<f32>::max();
+		u32 best_split = 0;
+		AABB left_bounds;
+		u32 left_count = 0;
+
+		for (u32 i = 1; i < SAH_BINS; i++) {
+			left_bounds = AABB::merge(left_bounds, bin_bounds[i - 1]);
+			left_count += bin_counts[i - 1];
+
+			if (left_count == 0 || left_count == leaves.size())
+				continue;
+
+			const f32 cost = left_bounds.surface_area() * static_cast<f32>(left_count) + right_costs[i];
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_split = i;
+			}
+		}
+
+		if (best_split > 0) {
+			const auto middle = std::partition(leaves.begin(), leaves.end(), [&](const u32 leaf) {
+				return bin_of(leaf) < best_split;
+			});
+			split = static_cast<usize>(middle - leaves.begin());
+		}
+	}
+
+	if (split == 0 || split == leaves.size())
+		split = leaves.size() / 2;
+
+	const u32 left = build_recursive(leaves.first(split));
+	const u32 right = build_recursive(leaves.subspan(split));
+	const u32 node = allocate_node();
+
+	m_nodes[node].left = left;
+	m_nodes[node].right = right;
+	m_nodes[node].bounds = AABB::merge(m_nodes[left].bounds, m_nodes[right].bounds);
+	m_nodes[left].parent = node;
+	m_nodes[right].parent = node;
+
+	return node;
+}
+
+void Bvh::flatten() {
+	if (!m_dirty)
+		return;
+
+	m_wide_nodes.clear();
+	m_wide_nodes.reserve(m_nodes.size() / 2 + 1);
+
+	for (auto& node : m_nodes) {
+		node.wide = INVALID;
+	}
+
+	if (m_root != INVALID)
+		flatten_recursive(m_root);
+
+	m_dirty = false;
+}
+
+// collapses up to two binary levels into one wide node, opening the largest child first
+u32 Bvh::flatten_recursive(const u32 node) {
+	const auto index = static_cast<u32>(m_wide_nodes.size());
+	m_wide_nodes.emplace_back();
+
+	std::array<u32, 4> children = {node};
+	u32 count = 1;
+
+	if (!m_nodes[node].is_leaf()) {
+		children = {m_nodes[node].left, m_nodes[node].right};
+		count = 2;
+	}
+
+	while (count < 4) {
+		u32 best = INVALID;
+		f32 best_area = -1.f;
+
+		for (u32 i = 0; i < count; i++) {
+			const Node& child = m_nodes[children[i]];
+			if (!child.is_leaf() && child.bounds.surface_area() > best_area) {
+				best = i;
+				best_area = child.bounds.surface_area();
+			}
+		}
+
+		if (best == INVALID)
+			break;
+
+		const u32 opened = children[best];
+		children[best] = m_nodes[opened].left;
+		children[count++] = m_nodes[opened].right;
+	}
+
+	for (u32 i = 0; i < 4; i++) {
+		u32 encoded = WideNode::EMPTY;
+		AABB bounds = {{EMPTY_MIN, EMPTY_MIN, EMPTY_MIN}, {EMPTY_MAX, EMPTY_MAX, EMPTY_MAX}};
+
+		if (i < count) {
+			Node& child = m_nodes[children[i]];
+			bounds = child.bounds;
+			child.wide = index;
+			child.slot = i;
+
+			if (child.is_leaf())
+				encoded = WideNode::LEAF | m_proxies[child.proxy].user_data;
+			else
+				encoded = flatten_recursive(children[i]);
+		}
+
+		// NOTE: recursion grows m_wide_nodes, so index back in instead of holding a reference
+		WideNode& wide = m_wide_nodes[index];
+		wide.min_x[i] = bounds.min.x;
+		wide.min_y[i] = bounds.min.y;
+		wide.min_z[i] = bounds.min.z;
+		wide.max_x[i] = bounds.max.x;
+		wide.max_y[i] = bounds.max.y;
+		wide.max_z[i] = bounds.max.z;
+		wide.children[i] = encoded;
+	}
+
+	return index;
+}
+
+RayHit Bvh::trace(const Ray& ray) const {
+	const glm::vec3 inv_dir = 1.f / ray.direction;
+
+	RayHit hit = {};
+	hit.t = ray.t_max;
+
+	f32 t_near[4];
+
+	traverse(
+		[&](const WideNode& node) { return test_ray(load_bounds(node), ray, inv_dir, hit.t, t_near); },
+		[&](const u32 user_data, const u32 slot) {
+			if (t_near[slot] < hit.t) {
+				hit.t = t_near[slot];
+				hit.user_data = user_data;
+			}
+		}
+	);
+
+	if (!hit.hit())
+		hit.t = std::numeric_limits<f32>::max();
+
+	return hit;
+}
+
+template<typename Test, typename Leaf>
+void Bvh::traverse(Test&& test, Leaf&& leaf) const {
+	if (m_wide_nodes.empty())
+		return;
+
+	thread_local std::vector<u32> stack;
+	stack.clear();
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		const WideNode& node = m_wide_nodes[stack.back()];
+		stack.pop_back();
+
+		u32 mask = test(node);
+
+		while (mask != 0) {
+			const auto slot = static_cast<u32>(std::countr_zero(mask));
+			mask &= mask - 1;
+
+			const u32 child = node.children[slot];
+			if (child & WideNode::LEAF)
+				leaf(child & ~WideNode::LEAF, slot);
+			else
+				stack.push_back(child);
+		}
+	}
+}
+
+} // namespace vg::scene
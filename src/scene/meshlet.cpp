@@ -0,0 +1,246 @@
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "scene/meshlet.hpp"
+
+namespace vg::scene {
+
+static constexpr u32 UNUSED = std::numeric_limits<u32>::max();
+
+// normals closer than this to perpendicular make the cone too wide to ever cull anything
+static constexpr f32 MIN_CONE_DOT = 0.1f;
+
+MeshletData MeshletBuilder::build(std::span<const glm::vec3> positions, std::span<const u32> indices) {
+	const auto vertex_count = static_cast<u32>(positions.size());
+	const auto triangle_count = static_cast<u32>(indices.size() / 3);
+
+	// vertex to triangle adjacency, used to find the next triangle sharing vertices with the current meshlet
+	std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+	std::vector<u32> adjacency(triangle_count * 3);
+
+	for (u32 i = 0; i < triangle_count * 3; i++) {
+		adjacency_offsets[indices[i] + 1]++;
+	}
+	for (u32 v = 0; v < vertex_count; v++) {
+		adjacency_offsets[v + 1] += adjacency_offsets[v];
+	}
+
+	std::vector<u32> fill = adjacency_offsets;
+	for (u32 i = 0; i < triangle_count * 3; i++) {
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	MeshletData data;
+	data.triangles.reserve(triangle_count);
+	data.indices.reserve(triangle_count * 3);
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<u32> local_index(vertex_count, UNUSED);
+
+	std::vector<u32> meshlet_vertices;
+	std::vector<u32> meshlet_triangles;
+	u32 next_unused = 0;
+
+	const auto new_vertex_count = [&](const u32 triangle) {
+		u32 count = 0;
+		for (u32 k = 0; k < 3; k++) {
+			count += local_index[indices[triangle * 3 + k]] == UNUSED ? 1 : 0;
+		}
+		return count;
+	};
+
+	const auto flush = [&] {
+		if (meshlet_triangles.empty())
+			return;
+
+		Meshlet meshlet;
+		meshlet.vertex_offset = static_cast<u32>(data.vertices.size());
+		meshlet.triangle_offset = static_cast<u32>(data.triangles.size());
+		meshlet.vertex_count = static_cast<u32>(meshlet_vertices.size());
+		meshlet.triangle_count = static_cast<u32>(meshlet_triangles.size());
+
+		data.vertices.insert(data.vertices.end(), meshlet_vertices.begin(), meshlet_vertices.end());
+
+		for (const u32 triangle : meshlet_triangles) {
+			const u32 a = indices[triangle * 3 + 0];
+			const u32 b = indices[triangle * 3 + 1];
+			const u32 c = indices[triangle * 3 + 2];
+
+			data.triangles.push_back(local_index[a] | (local_index[b] << 8) | (local_index[c] << 16));
+			data.indices.insert(data.indices.end(), {a, b, c});
+		}
+
+		data.meshlets.push_back(meshlet);
+		data.bounds.push_back(compute_bounds(positions, indices, meshlet_triangles));
+
+		for (const u32 vertex : meshlet_vertices) {
+			local_index[vertex] = UNUSED;
+		}
+
+		meshlet_vertices.clear();
+		meshlet_triangles.clear();
+	};
+
+	for (u32 emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+		// prefer the neighbouring triangle that adds the fewest new vertices
+		u32 best = UNUSED;
+		u32 best_cost = 4;
+
+		for (const u32 vertex : meshlet_vertices) {
+			for (u32 i = adjacency_offsets[vertex]; i < adjacency_offsets[vertex + 1] && best_cost > 0; i++) {
+				const u32 triangle = adjacency[i];
+				if (emitted[triangle])
+					continue;
+
+				const u32 cost = new_vertex_count(triangle);
+				if (cost < best_cost) {
+					best = triangle;
+					best_cost = cost;
+				}
+			}
+		}
+
+		// nothing connected left, continue with the next triangle in index order
+		if (best == UNUSED) {
+			while (emitted[next_unused]) {
+				next_unused++;
+			}
+
+			best = next_unused;
+			best_cost = new_vertex_count(best);
+		}
+
+		if (meshlet_vertices.size() + best_cost > MAX_VERTICES || meshlet_triangles.size() + 1 > MAX_TRIANGLES) {
+			flush();
+			best_cost = 3;
+		}
+
+		for (u32 k = 0; k < 3; k++) {
+			const u32 vertex = indices[best * 3 + k];
+			if (local_index[vertex] == UNUSED) {
+				local_index[vertex] = static_cast<u32>(meshlet_vertices.size());
+				meshlet_vertices.push_back(vertex);
+			}
+		}
+
+		meshlet_triangles.push_back(best);
+		emitted[best] = true;
+	}
+
+	flush();
+	return data;
+}
+
+MeshletBounds MeshletBuilder::compute_bounds(
+	std::span<const glm::vec3> positions,
+	std::span<const u32> indices,
+	std::span<const u32> triangles
+) {
+	MeshletBounds bounds;
+
+	// Ritter's bounding sphere, start from two distant points and grow to fit the rest
+	const auto farthest_from = [&](const glm::vec3& point) {
+		glm::vec3 result = point;
+		f32 max_distance = -1.f;
+
+		for (const u32 triangle : triangles) {
+			for (u32 k = 0; k < 3; k++) {
+				const glm::vec3& p = positions[indices[triangle * 3 + k]];
+				const f32 distance = glm::dot(p - point, p - point);
+
+				if (distance > max_distance) {
+					max_distance = distance;
+					result = p;
+				}
+			}
+		}
+
+		return result;
+	};
+
+	const glm::vec3 a = farthest_from(positions[indices[triangles[0] * 3]]);
+	const glm::vec3 b = farthest_from(a);
+
+	glm::vec3 center = (a + b) * 0.5f;
+	f32 radius = glm::length(b - a) * 0.5f;
+
+	for (const u32 triangle : triangles) {
+		for (u32 k = 0; k < 3; k++) {
+			const glm::vec3& p = positions[indices[triangle * 3 + k]];
+			const f32 distance = glm::length(p - center);
+
+			if (distance > radius) {
+				const f32 new_radius = (radius + distance) * 0.5f;
+				center += (p - center) * ((new_radius - radius) / distance);
+				radius = new_radius;
+			}
+		}
+	}
+
+	bounds.center = center;
+	bounds.radius = radius;
+
+	// normal cone, the axis is the average normal and the cutoff comes from the widest deviation from it
+	std::vector<glm::vec3> normals;
+	normals.reserve(triangles.size());
+
+	glm::vec3 axis = glm::vec3(0.f);
+
+	for (const u32 triangle : triangles) {
+		const glm::vec3& p0 = positions[indices[triangle * 3 + 0]];
+		const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+		const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+		const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const f32 area = glm::length(normal);
+
+		// NOTE: degenerate triangles are never rasterized, they don't constrain the cone
+		if (area <= 0.f)
+			continue;
+
+		normals.push_back(normal / area);
+		axis += normal / area;
+	}
+
+	const f32 axis_length = glm::length(axis);
+	if (normals.empty() || axis_length <= 0.f)
+		return bounds;
+
+	axis /= axis_length;
+
+	f32 min_dot = 1.f;
+	for (const glm::vec3& normal : normals) {
+		min_dot = std::min(min_dot, glm::dot(axis, normal));
+	}
+
+	if (min_dot <= MIN_CONE_DOT)
+		return bounds;
+
+	// move the apex back along the axis until every triangle's plane is in front of it
+	f32 max_t = 0.f;
+	usize n = 0;
+
+	for (const u32 triangle : triangles) {
+		const glm::vec3& p0 = positions[indices[triangle * 3 + 0]];
+		const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+		const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+		if (glm::length(glm::cross(p1 - p0, p2 - p0)) <= 0.f)
+			continue;
+
+		const glm::vec3& normal = normals[n++];
+		const f32 t = glm::dot(center - p0, normal) / glm::dot(axis, normal);
+		max_t = std::max(max_t, t);
+	}
+
+	bounds.cone_apex = center - axis * max_t;
+	bounds.cone_axis = axis;
+	bounds.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+
+	return bounds;
+}
+
+} // namespace vg::scene
@@ -0,0 +1,164 @@
+#include <print>
+#include <stdexcept>
+
+#include "task_graph.hpp"
+
+namespace vg {
+
+static f64 to_ms(const std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<f64, std::milli>(duration).count();
+}
+
+TaskGraph::TaskGraph(ThreadPool& thread_pool) : m_thread_pool(thread_pool) {}
+
+TaskGraph::TaskId TaskGraph::add(
+	std::string name,
+	std::function<void()> fn,
+	std::initializer_list<TaskId> dependencies
+) {
+	return add_task(std::move(name), std::move(fn), false, dependencies);
+}
+
+TaskGraph::TaskId TaskGraph::add_main(
+	std::string name,
+	std::function<void()> fn,
+	std::initializer_list<TaskId> dependencies
+) {
+	return add_task(std::move(name), std::move(fn), true, dependencies);
+}
+
+void TaskGraph::run() {
+	m_start = Clock::now();
+	m_pending = static_cast<u32>(m_tasks.size());
+
+	for (const auto& task : m_tasks) {
+		task->remaining = task->dependency_count;
+	}
+
+	for (TaskId id = 0; id < m_tasks.size(); id++) {
+		if (m_tasks[id]->dependency_count == 0)
+			schedule(id);
+	}
+
+	std::unique_lock lock(m_mutex);
+
+	while (m_pending > 0) {
+		m_condition.wait(lock, [this] { return m_pending == 0 || !m_main_queue.empty(); });
+
+		while (!m_main_queue.empty()) {
+			const TaskId id = m_main_queue.front();
+			m_main_queue.pop_front();
+
+			lock.unlock();
+			execute(id);
+			lock.lock();
+		}
+	}
+
+	m_end = Clock::now();
+
+	if (m_exception)
+		std::rethrow_exception(m_exception);
+}
+
+std::vector<TaskTiming> TaskGraph::get_timings() const {
+	std::vector<TaskTiming> timings;
+	timings.reserve(m_tasks.size());
+
+	for (const auto& task : m_tasks) {
+		TaskTiming timing;
+		timing.name = task->name;
+		timing.start_ms = to_ms(task->start - m_start);
+		timing.duration_ms = to_ms(task->end - task->start);
+		timing.main_thread = task->main_thread;
+		timings.push_back(timing);
+	}
+
+	return timings;
+}
+
+void TaskGraph::report() const {
+	f64 busy = 0.0;
+
+	for (const auto& timing : get_timings()) {
+		std::println(
+			"[startup] {:<16} {:>8.2f} ms +{:>8.2f} ms{}",
+			timing.name,
+			timing.start_ms,
+			timing.duration_ms,
+			timing.main_thread ? " (main thread)" : ""
+		);
+		busy += timing.duration_ms;
+	}
+
+	// anything below the summed stage time is what running them concurrently saved
+	std::println("[startup] total {:.2f} ms, stages sum to {:.2f} ms", to_ms(m_end - m_start), busy);
+}
+
+TaskGraph::TaskId TaskGraph::add_task(
+	std::string name,
+	std::function<void()> fn,
+	const bool main_thread,
+	std::initializer_list<TaskId> dependencies
+) {
+	const auto id = static_cast<TaskId>(m_tasks.size());
+
+	auto task = std::make_unique<Task>();
+	task->name = std::move(name);
+	task->fn = std::move(fn);
+	task->main_thread = main_thread;
+
+	// NOTE: dependencies have to be added first, which also rules out cycles
+	for (const TaskId dependency : dependencies) {
+		if (dependency >= id)
+			throw std::runtime_error("Task depends on a task that was added after it");
+
+		m_tasks[dependency]->dependents.push_back(id);
+		task->dependency_count++;
+	}
+
+	m_tasks.push_back(std::move(task));
+	return id;
+}
+
+void TaskGraph::schedule(const TaskId id) {
+	if (m_tasks[id]->main_thread) {
+		std::lock_guard lock(m_mutex);
+		m_main_queue.push_back(id);
+		m_condition.notify_all();
+		return;
+	}
+
+	m_thread_pool.submit([this, id] { execute(id); });
+}
+
+void TaskGraph::execute(const TaskId id) {
+	Task& task = *m_tasks[id];
+	task.start = Clock::now();
+
+	// once something failed the rest only drains, so run() can rethrow
+	if (!m_failed) {
+		try {
+			task.fn();
+		} catch (...) {
+			std::lock_guard lock(m_mutex);
+			if (!m_exception)
+				m_exception = std::current_exception();
+			m_failed = true;
+		}
+	}
+
+	task.end = Clock::now();
+
+	for (const TaskId dependent : task.dependents) {
+		if (m_tasks[dependent]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			schedule(dependent);
+	}
+
+	// NOTE: notify under the lock, run() may return and destroy the graph as soon as it is released
+	std::lock_guard lock(m_mutex);
+	m_pending--;
+	m_condition.notify_all();
+}
+
+} // namespace vg
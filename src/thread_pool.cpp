@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <exception>
+#include <latch>
+
+#include "thread_pool.hpp"
+
+namespace vg {
+
+ThreadPool::ThreadPool(const u32 thread_count) {
+	m_threads.reserve(thread_count);
+
+	for (u32 i = 0; i < thread_count; i++) {
+		m_threads.emplace_back([this](const std::stop_token& stop) { worker(stop); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	for (auto& thread : m_threads) {
+		thread.request_stop();
+	}
+
+	m_condition.notify_all();
+	m_threads.clear();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+	{
+		std::lock_guard lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+
+	m_condition.notify_one();
+}
+
+void ThreadPool::parallel_for(const usize count, const usize min_chunk, const std::function<void(usize, usize)>& fn) {
+	if (count == 0)
+		return;
+
+	const usize max_chunks = (count + std::max<usize>(min_chunk, 1) - 1) / std::max<usize>(min_chunk, 1);
+	const usize chunks = std::min<usize>(max_chunks, get_thread_count() + 1);
+
+	if (chunks <= 1) {
+		fn(0, count);
+		return;
+	}
+
+	const usize chunk_size = (count + chunks - 1) / chunks;
+	std::latch done(static_cast<std::ptrdiff_t>(chunks - 1));
+
+	// NOTE: a throwing chunk must still count down, the first exception is rethrown once every chunk is done
+	std::exception_ptr error;
+	std::mutex error_mutex;
+
+	const auto run_chunk = [&fn, &error, &error_mutex](const usize begin, const usize end) {
+		try {
+			if (begin < end)
+				fn(begin, end);
+		} catch (...) {
+			std::lock_guard lock(error_mutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	for (usize chunk = 1; chunk < chunks; chunk++) {
+		const usize begin = chunk * chunk_size;
+		const usize end = std::min(begin + chunk_size, count);
+
+		submit([&run_chunk, &done, begin, end] {
+			run_chunk(begin, end);
+			done.count_down();
+		});
+	}
+
+	run_chunk(0, std::min(chunk_size, count));
+
+	// help out instead of blocking, otherwise nested calls from workers could starve the pool
+	while (!done.try_wait()) {
+		if (!run_pending())
+			std::this_thread::yield();
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+u32 ThreadPool::default_thread_count() {
+	return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+}
+
+void ThreadPool::worker(const std::stop_token& stop) {
+	while (true) {
+		std::function<void()> task;
+
+		{
+			std::unique_lock lock(m_mutex);
+			if (!m_condition.wait(lock, stop, [this] { return !m_tasks.empty(); }))
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+bool ThreadPool::run_pending() {
+	std::function<void()> task;
+
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_tasks.empty())
+			return false;
+
+		task = std::move(m_tasks.front());
+		m_tasks.pop_front();
+	}
+
+	task();
+	return true;
+}
+
+} // namespace vg
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "gfx/allocator.hpp"
+
+using namespace vg;
+using namespace vg::gfx;
+
+static void test_rounding() {
+	TlsfAllocator allocator(1 << 20, 256);
+
+	const auto small = allocator.allocate(100);
+	CHECK(small.has_value());
+	CHECK(small->size == 256);
+	CHECK(small->offset % 256 == 0);
+
+	const auto aligned = allocator.allocate(256, 4096);
+	CHECK(aligned.has_value());
+	CHECK(aligned->offset % 4096 == 0);
+
+	CHECK(allocator.get_used() == small->size + aligned->size);
+	CHECK(!allocator.allocate(0).has_value());
+	CHECK(!allocator.allocate(allocator.get_capacity() + 1).has_value());
+}
+
+// random allocations never overlap, freeing everything merges the blocks back into one
+static void test_random() {
+	constexpr u64 CAPACITY = 1 << 24;
+	TlsfAllocator allocator(CAPACITY, 64);
+
+	std::mt19937 rng(42);
+	std::vector<TlsfAllocator::Allocation> live;
+
+	for (u32 round = 0; round < 4000; round++) {
+		if (!live.empty() && rng() % 3 == 0) {
+			const usize index = rng() % live.size();
+			allocator.free(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+			continue;
+		}
+
+		const u64 size = 1 + rng() % 65536;
+		const u64 alignment = u64(1) << (rng() % 13);
+
+		if (const auto allocation = allocator.allocate(size, alignment)) {
+			CHECK(allocation->size >= size);
+			CHECK(allocation->offset % std::max<u64>(alignment, 64) == 0);
+			CHECK(allocation->offset + allocation->size <= CAPACITY);
+			live.push_back(*allocation);
+		}
+	}
+
+	std::ranges::sort(live, {}, &TlsfAllocator::Allocation::offset);
+
+	u64 used = 0;
+	for (usize i = 0; i < live.size(); i++) {
+		if (i > 0)
+			CHECK(live[i - 1].offset + live[i - 1].size <= live[i].offset);
+		used += live[i].size;
+	}
+
+	CHECK(allocator.get_used() == used);
+
+	for (const auto& allocation : live) {
+		allocator.free(allocation);
+	}
+
+	CHECK(allocator.is_empty());
+
+	const auto large = allocator.allocate(CAPACITY / 2);
+	CHECK(large.has_value());
+	CHECK(large->offset == 0);
+}
+
+int main() {
+	test_rounding();
+	test_random();
+	return 0;
+}
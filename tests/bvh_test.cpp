@@ -0,0 +1,135 @@
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "scene/bvh.hpp"
+
+using namespace vg;
+using namespace vg::scene;
+
+struct Object {
+	AABB bounds;
+	u32 proxy = Bvh::INVALID;
+};
+
+static AABB random_box(std::mt19937& rng) {
+	std::uniform_real_distribution<f32> position(-50.f, 50.f);
+	std::uniform_real_distribution<f32> extent(0.1f, 2.f);
+
+	const glm::vec3 center = {position(rng), position(rng), position(rng)};
+	const glm::vec3 half = {extent(rng), extent(rng), extent(rng)};
+	return {center - half, center + half};
+}
+
+static bool overlaps(const AABB& box, const Sphere& sphere) {
+	const glm::vec3 delta = glm::clamp(sphere.center, box.min, box.max) - sphere.center;
+	return glm::dot(delta, delta) <= sphere.radius * sphere.radius;
+}
+
+// slab test, the nearest entry distance or the ray's t_max when it misses
+static f32 intersect(const AABB& box, const Ray& ray) {
+	const glm::vec3 inv_dir = 1.f / ray.direction;
+	const glm::vec3 t1 = (box.min - ray.origin) * inv_dir;
+	const glm::vec3 t2 = (box.max - ray.origin) * inv_dir;
+
+	const glm::vec3 t_min = glm::min(t1, t2);
+	const glm::vec3 t_max = glm::max(t1, t2);
+	const f32 t_enter = std::max({t_min.x, t_min.y, t_min.z, 0.f});
+	const f32 t_exit = std::min({t_max.x, t_max.y, t_max.z, ray.t_max});
+
+	return t_enter <= t_exit ? t_enter : ray.t_max;
+}
+
+// every query has to match a brute force pass over the live objects
+static void check_queries(Bvh& bvh, const std::vector<Object>& objects, std::mt19937& rng) {
+	std::uniform_real_distribution<f32> position(-60.f, 60.f);
+	std::uniform_real_distribution<f32> unit(-1.f, 1.f);
+
+	for (u32 i = 0; i < 32; i++) {
+		const Sphere sphere = {{position(rng), position(rng), position(rng)}, 15.f};
+
+		std::vector<u32> results;
+		bvh.query_sphere(sphere, results);
+		std::ranges::sort(results);
+
+		std::vector<u32> expected;
+		for (u32 id = 0; id < objects.size(); id++) {
+			if (objects[id].proxy != Bvh::INVALID && overlaps(objects[id].bounds, sphere))
+				expected.push_back(id);
+		}
+
+		CHECK(results == expected);
+	}
+
+	// rays start outside the scene so no two boxes are hit at the same distance
+	for (u32 i = 0; i < 32; i++) {
+		const glm::vec3 target = {position(rng), position(rng), position(rng)};
+
+		Ray ray;
+		ray.origin = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng))) * 150.f;
+		ray.direction = glm::normalize(target - ray.origin);
+		ray.t_max = 1000.f;
+
+		RayHit expected;
+		for (u32 id = 0; id < objects.size(); id++) {
+			if (objects[id].proxy == Bvh::INVALID)
+				continue;
+
+			const f32 t = intersect(objects[id].bounds, ray);
+			if (t < ray.t_max && t < expected.t) {
+				expected.t = t;
+				expected.user_data = id;
+			}
+		}
+
+		const RayHit hit = bvh.raycast(ray);
+		CHECK(hit.user_data == expected.user_data);
+		if (hit.hit())
+			CHECK(std::abs(hit.t - expected.t) < 1e-3f);
+	}
+}
+
+int main() {
+	std::mt19937 rng(7);
+	Bvh bvh;
+	std::vector<Object> objects(500);
+
+	for (u32 id = 0; id < objects.size(); id++) {
+		objects[id].bounds = random_box(rng);
+		objects[id].proxy = bvh.insert(objects[id].bounds, id);
+	}
+
+	CHECK(bvh.get_proxy_count() == objects.size());
+	check_queries(bvh, objects, rng);
+
+	// removed objects must not show up anymore
+	for (u32 id = 0; id < objects.size(); id += 3) {
+		bvh.remove(objects[id].proxy);
+		objects[id].proxy = Bvh::INVALID;
+	}
+
+	check_queries(bvh, objects, rng);
+
+	// updates between queries go through the in place refit of the wide nodes
+	for (u32 frame = 0; frame < 8; frame++) {
+		for (u32 id = 1; id < objects.size(); id += 7) {
+			if (objects[id].proxy == Bvh::INVALID)
+				continue;
+
+			objects[id].bounds = random_box(rng);
+			bvh.update(objects[id].proxy, objects[id].bounds);
+		}
+
+		check_queries(bvh, objects, rng);
+	}
+
+	bvh.rebuild();
+	check_queries(bvh, objects, rng);
+
+	return 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal check for the test executables, a failure prints the expression and exits with a non-zero code
+#define CHECK(condition)                                                                             \
+	do {                                                                                             \
+		if (!(condition)) {                                                                          \
+			std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);       \
+			std::exit(EXIT_FAILURE);                                                                 \
+		}                                                                                            \
+	} while (false)
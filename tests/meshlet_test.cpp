@@ -0,0 +1,118 @@
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "check.hpp"
+#include "scene/meshlet.hpp"
+
+using namespace vg;
+using namespace vg::scene;
+
+using Triangle = std::array<u32, 3>;
+
+// rotated so the smallest index comes first, which keeps the winding comparable
+static Triangle canonical(const u32 a, const u32 b, const u32 c) {
+	if (a <= b && a <= c)
+		return {a, b, c};
+	if (b <= a && b <= c)
+		return {b, c, a};
+	return {c, a, b};
+}
+
+// a grid of quads, plus a fan around one vertex that alone has more triangles than a meshlet can hold
+static void build_mesh(std::vector<glm::vec3>& positions, std::vector<u32>& indices) {
+	constexpr u32 GRID = 40;
+	constexpr u32 FAN = 300;
+
+	for (u32 y = 0; y <= GRID; y++) {
+		for (u32 x = 0; x <= GRID; x++) {
+			positions.emplace_back(static_cast<f32>(x), static_cast<f32>(y), 0.f);
+		}
+	}
+
+	for (u32 y = 0; y < GRID; y++) {
+		for (u32 x = 0; x < GRID; x++) {
+			const u32 corner = y * (GRID + 1) + x;
+			indices.insert(indices.end(), {corner, corner + 1, corner + GRID + 1});
+			indices.insert(indices.end(), {corner + 1, corner + GRID + 2, corner + GRID + 1});
+		}
+	}
+
+	const auto center = static_cast<u32>(positions.size());
+	positions.emplace_back(0.f, 0.f, 10.f);
+
+	for (u32 i = 0; i <= FAN; i++) {
+		const f32 angle = 6.2831853f * static_cast<f32>(i) / FAN;
+		positions.emplace_back(std::cos(angle), std::sin(angle), 10.f);
+	}
+
+	for (u32 i = 0; i < FAN; i++) {
+		indices.insert(indices.end(), {center, center + 1 + i, center + 2 + i});
+	}
+}
+
+int main() {
+	std::vector<glm::vec3> positions;
+	std::vector<u32> indices;
+	build_mesh(positions, indices);
+
+	const MeshletData data = MeshletBuilder::build(positions, indices);
+
+	CHECK(data.bounds.size() == data.meshlets.size());
+	CHECK(data.get_triangle_count() * 3 == indices.size());
+	CHECK(data.indices.size() == indices.size());
+
+	std::vector<Triangle> emitted;
+	u32 vertex_offset = 0;
+	u32 triangle_offset = 0;
+
+	for (usize m = 0; m < data.meshlets.size(); m++) {
+		const Meshlet& meshlet = data.meshlets[m];
+		const MeshletBounds& bounds = data.bounds[m];
+
+		CHECK(meshlet.vertex_count > 0 && meshlet.vertex_count <= MeshletBuilder::MAX_VERTICES);
+		CHECK(meshlet.triangle_count > 0 && meshlet.triangle_count <= MeshletBuilder::MAX_TRIANGLES);
+
+		// meshlets are packed back to back
+		CHECK(meshlet.vertex_offset == vertex_offset);
+		CHECK(meshlet.triangle_offset == triangle_offset);
+		vertex_offset += meshlet.vertex_count;
+		triangle_offset += meshlet.triangle_count;
+
+		for (u32 t = 0; t < meshlet.triangle_count; t++) {
+			const u32 packed = data.triangles[meshlet.triangle_offset + t];
+			std::array<u32, 3> corners;
+
+			for (u32 k = 0; k < 3; k++) {
+				const u32 local = (packed >> (k * 8)) & 0xff;
+				CHECK(local < meshlet.vertex_count);
+
+				corners[k] = data.vertices[meshlet.vertex_offset + local];
+				CHECK(glm::distance(positions[corners[k]], bounds.center) <= bounds.radius + 1e-3f);
+
+				// the indexed draw copy has to list the same vertices in the same order
+				CHECK(data.indices[(meshlet.triangle_offset + t) * 3 + k] == corners[k]);
+			}
+
+			emitted.push_back(canonical(corners[0], corners[1], corners[2]));
+		}
+	}
+
+	CHECK(vertex_offset == data.vertices.size());
+	CHECK(triangle_offset == data.triangles.size());
+
+	// every input triangle comes out exactly once, with its winding intact
+	std::vector<Triangle> expected;
+	for (usize i = 0; i < indices.size(); i += 3) {
+		expected.push_back(canonical(indices[i], indices[i + 1], indices[i + 2]));
+	}
+
+	std::ranges::sort(emitted);
+	std::ranges::sort(expected);
+	CHECK(emitted == expected);
+
+	return 0;
+}
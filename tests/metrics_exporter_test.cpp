@@ -0,0 +1,75 @@
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "metrics.hpp"
+#include "metrics_exporter.hpp"
+
+using namespace vg;
+
+static std::vector<std::string> split_lines(const std::string& text) {
+	std::vector<std::string> lines;
+	usize begin = 0;
+
+	// every line, including the last one, ends in a newline
+	for (usize end = text.find('\n'); end != std::string::npos; end = text.find('\n', begin)) {
+		lines.push_back(text.substr(begin, end - begin));
+		begin = end + 1;
+	}
+
+	CHECK(begin == text.size());
+	return lines;
+}
+
+static MetricsSnapshot snapshot_at(const MetricsRegistry& registry, const std::chrono::seconds time) {
+	MetricsSnapshot snapshot = registry.snapshot();
+	snapshot.time = std::chrono::system_clock::time_point(time);
+	return snapshot;
+}
+
+int main() {
+	static constexpr std::array<f64, 3> BOUNDS = {1.0, 2.0, 4.0};
+
+	MetricsRegistry registry;
+	registry.counter("frames").add(3);
+	registry.counter("device_messages", "source=nvrhi,severity=Error").add();
+	registry.gauge("gpu_memory_bytes", "type=usage").set(1.5);
+
+	auto& frame_time = registry.histogram("frame_time_ms", BOUNDS);
+	for (const f64 value : {1.0, 2.0, 3.0, 4.0}) {
+		frame_time.record(value);
+	}
+
+	const MetricsSnapshot first = snapshot_at(registry, std::chrono::seconds(1700000000));
+	const auto lines = split_lines(MetricsExporter::format(first, {}));
+
+	// <name>,app=vanguard[,<tags>] <fields> <unix time in ns>
+	CHECK(lines.size() == 4);
+	CHECK(lines[0] == "frames,app=vanguard value=3i 1700000000000000000");
+	CHECK(lines[1] == "device_messages,app=vanguard,source=nvrhi,severity=Error value=1i 1700000000000000000");
+	CHECK(lines[2] == "gpu_memory_bytes,app=vanguard,type=usage value=1.5 1700000000000000000");
+	CHECK(lines[3].starts_with("frame_time_ms,app=vanguard count=4i,sum=10,mean=2.5,p50="));
+	CHECK(lines[3].contains(",p95="));
+	CHECK(lines[3].contains(",p99="));
+	CHECK(lines[3].ends_with(" 1700000000000000000"));
+
+	// histograms only report the samples since the previous export and are left out when there are none
+	const MetricsSnapshot idle = snapshot_at(registry, std::chrono::seconds(1700000001));
+	const auto idle_lines = split_lines(MetricsExporter::format(idle, first));
+
+	CHECK(idle_lines.size() == 3);
+	CHECK(idle_lines[0] == "frames,app=vanguard value=3i 1700000001000000000");
+
+	frame_time.record(8.0);
+
+	const MetricsSnapshot next = snapshot_at(registry, std::chrono::seconds(1700000002));
+	const auto next_lines = split_lines(MetricsExporter::format(next, idle));
+
+	CHECK(next_lines.size() == 4);
+	CHECK(next_lines[3].starts_with("frame_time_ms,app=vanguard count=1i,sum=8,mean=8,"));
+
+	return 0;
+}
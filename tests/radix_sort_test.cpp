@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "gfx/radix_sort.hpp"
+
+using namespace vg;
+using namespace vg::gfx;
+
+// keys repeat so the comparison also catches entries with equal keys changing order
+static std::vector<SortEntry> random_entries(const usize count, const u64 key_range) {
+	std::mt19937_64 rng(count);
+	std::vector<SortEntry> entries(count);
+
+	for (usize i = 0; i < count; i++) {
+		entries[i] = {rng() % key_range, static_cast<u32>(i)};
+	}
+
+	return entries;
+}
+
+static void check_sort(RadixSort& sort, std::vector<SortEntry> entries) {
+	std::vector<SortEntry> expected = entries;
+	std::ranges::stable_sort(expected, {}, &SortEntry::key);
+
+	sort.sort(entries);
+
+	for (usize i = 0; i < entries.size(); i++) {
+		CHECK(entries[i].key == expected[i].key);
+		CHECK(entries[i].index == expected[i].index);
+	}
+}
+
+int main() {
+	ThreadPool thread_pool(4);
+	RadixSort serial;
+	RadixSort parallel(&thread_pool);
+
+	for (const usize count : {usize(0), usize(1), usize(100), RadixSort::PARALLEL_THRESHOLD - 1}) {
+		check_sort(serial, random_entries(count, 1000));
+		check_sort(parallel, random_entries(count, 1000));
+	}
+
+	// above the threshold the parallel path runs, with narrow keys most digit passes are skipped
+	for (const usize count : {RadixSort::PARALLEL_THRESHOLD, usize(10000), usize(100003)}) {
+		check_sort(parallel, random_entries(count, 1000));
+		check_sort(parallel, random_entries(count, ~u64(0)));
+		check_sort(serial, random_entries(count, ~u64(0)));
+	}
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include <array>
+#include <atomic>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+
+using namespace vg;
+
+// every task has to see all of its dependencies finished, main thread tasks run on the caller
+static void test_ordering(ThreadPool& thread_pool) {
+	constexpr u32 COUNT = 6;
+
+	TaskGraph graph(thread_pool);
+	std::array<std::atomic<bool>, COUNT> done = {};
+	std::atomic<bool> ordered = true;
+	std::atomic<bool> on_main_thread = false;
+	const std::thread::id caller = std::this_thread::get_id();
+
+	const auto task = [&](const u32 id, std::initializer_list<u32> dependencies) {
+		return [&, id, dependencies = std::vector<u32>(dependencies)] {
+			for (const u32 dependency : dependencies) {
+				if (!done[dependency])
+					ordered = false;
+			}
+			done[id] = true;
+		};
+	};
+
+	const auto a = graph.add("a", task(0, {}));
+	const auto b = graph.add("b", task(1, {0}), {a});
+	const auto c = graph.add("c", task(2, {0}), {a});
+	const auto d = graph.add("d", task(3, {1, 2}), {b, c});
+	const auto on_main = graph.add_main(
+		"main",
+		[&, inner = task(4, {3})] {
+			inner();
+			on_main_thread = std::this_thread::get_id() == caller;
+		},
+		{d}
+	);
+	graph.add("e", task(5, {0, 4}), {a, on_main});
+
+	graph.run();
+
+	for (const auto& flag : done) {
+		CHECK(flag);
+	}
+
+	CHECK(ordered);
+	CHECK(on_main_thread);
+}
+
+// dependencies have to exist before the task that names them, so a cycle can't be expressed
+static void test_cycles(ThreadPool& thread_pool) {
+	TaskGraph graph(thread_pool);
+	const auto a = graph.add("a", [] {});
+
+	bool forward = false;
+	try {
+		graph.add("b", [] {}, {a + 1});
+	} catch (const std::runtime_error&) {
+		forward = true;
+	}
+
+	bool later = false;
+	try {
+		graph.add("c", [] {}, {a, a + 5});
+	} catch (const std::runtime_error&) {
+		later = true;
+	}
+
+	CHECK(forward);
+	CHECK(later);
+}
+
+// the first exception is rethrown from run(), tasks after the failure are skipped
+static void test_exception(ThreadPool& thread_pool) {
+	TaskGraph graph(thread_pool);
+	std::atomic<bool> skipped = true;
+
+	const auto fail = graph.add("fail", [] { throw std::runtime_error("Task failed"); });
+	graph.add("after", [&] { skipped = false; }, {fail});
+
+	bool thrown = false;
+	try {
+		graph.run();
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+
+	CHECK(thrown);
+	CHECK(skipped);
+}
+
+// a throwing chunk must not leave the caller waiting, the exception comes out once every chunk is done
+static void test_parallel_for_exception(ThreadPool& thread_pool) {
+	std::atomic<usize> visited = 0;
+
+	bool thrown = false;
+	try {
+		thread_pool.parallel_for(1000, 10, [&](const usize begin, const usize end) {
+			visited += end - begin;
+			if (begin == 0)
+				throw std::runtime_error("Chunk failed");
+		});
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+
+	CHECK(thrown);
+	CHECK(visited == 1000);
+}
+
+int main() {
+	ThreadPool thread_pool(4);
+
+	test_ordering(thread_pool);
+	test_cycles(thread_pool);
+	test_exception(thread_pool);
+	test_parallel_for_exception(thread_pool);
+
+	return 0;
+}